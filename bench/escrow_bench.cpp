@@ -0,0 +1,174 @@
+#include "escrow.hpp"
+
+#include <eosio/host.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using eosio::host::chain;
+using eosio::host::push_action;
+
+// ns/op of the escrow actions as the tables grow, run on the host chain
+//
+//   escrow_bench [--max-rows N] [--ops K]
+//
+// Every table size is prefilled with funded escrows of a single sender, the worst case of a per-sender scan
+// K escrows are then created, funded, approved & claimed, and K more are refunded once expired
+
+namespace {
+
+    const name SELF = "escrow.bos"_n;
+    const name TOKEN = "eosio.token"_n;
+    const name SENDER = "bet.bos"_n;
+    const name RECEIVER = "receiver"_n;
+    const name APPROVER = "eosio"_n;
+    const asset DEPOSIT{10000, symbol{"BOS", 4}};
+
+    // 2020-01-01T00:00:00, escrows expire 30 days later
+    constexpr uint32_t START = 1577836800;
+    constexpr uint32_t EXPIRY = 30 * 24 * 60 * 60;
+
+    // Unique escrow name of the i-th escrow, "esc" followed by i in base 31
+    name escrow_name_of( uint64_t i ) {
+        static const char* digits = "12345abcdefghijklmnopqrstuvwxyz";
+        string str = "esc";
+        do {
+            str += digits[i % 31];
+            i /= 31;
+        } while (i > 0);
+        return name{str};
+    }
+
+    void init( const uint64_t i ) {
+        push_action(SELF, SELF, {SENDER}, &escrow::init, SENDER, RECEIVER, APPROVER, escrow_name_of(i), time_point_sec(START + EXPIRY), string("benchmark"));
+    }
+
+    void transfer( const string& memo ) {
+        push_action(SELF, TOKEN, {SENDER}, &escrow::transfer, SENDER, SELF, DEPOSIT, memo);
+    }
+
+    void approve( const uint64_t i ) {
+        push_action(SELF, SELF, {APPROVER}, &escrow::approve, escrow_name_of(i), APPROVER);
+    }
+
+    void claim( const uint64_t i ) {
+        push_action(SELF, SELF, {RECEIVER}, &escrow::claim, escrow_name_of(i));
+    }
+
+    void refund( const uint64_t i ) {
+        push_action(SELF, SELF, {SENDER}, &escrow::refund, escrow_name_of(i));
+    }
+
+    void reset_chain() {
+        auto& state = chain();
+        state.reset();
+        state.now = time_point_sec(START);
+        state.accounts = {SELF, TOKEN, SENDER, RECEIVER, APPROVER};
+    }
+
+    struct timer {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+        int64_t elapsed_ns() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        }
+    };
+
+    struct result {
+        int64_t init = 0;
+        int64_t transfer = 0;
+        int64_t approve = 0;
+        int64_t claim = 0;
+        int64_t refund = 0;
+    };
+
+    result run( const uint64_t rows, const uint64_t ops ) {
+        reset_chain();
+        result total;
+
+        // Funded escrows already in the table, addressed by memo so the prefill stays linear
+        for (uint64_t i = 0; i < rows; ++i) {
+            init(i);
+            transfer(escrow_name_of(i).to_string());
+        }
+
+        // Init & fund one escrow at a time, the transfer without memo finds the only empty escrow of the sender
+        for (uint64_t i = rows; i < rows + ops; ++i) {
+            timer t_init;
+            init(i);
+            total.init += t_init.elapsed_ns();
+
+            timer t_transfer;
+            transfer("");
+            total.transfer += t_transfer.elapsed_ns();
+        }
+
+        for (uint64_t i = rows; i < rows + ops; ++i) {
+            timer t;
+            approve(i);
+            total.approve += t.elapsed_ns();
+        }
+
+        for (uint64_t i = rows; i < rows + ops; ++i) {
+            timer t;
+            claim(i);
+            total.claim += t.elapsed_ns();
+        }
+
+        // Refunds need expired escrows, create them now & move the clock past their expiry
+        for (uint64_t i = rows + ops; i < rows + 2 * ops; ++i) {
+            init(i);
+            transfer("");
+        }
+        chain().now = time_point_sec(START + EXPIRY + 1);
+
+        for (uint64_t i = rows + ops; i < rows + 2 * ops; ++i) {
+            timer t;
+            refund(i);
+            total.refund += t.elapsed_ns();
+        }
+
+        return total;
+    }
+}
+
+int main( int argc, char** argv ) {
+    uint64_t max_rows = 1000000;
+    uint64_t ops = 1000;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max-rows") == 0) {
+            max_rows = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ops") == 0) {
+            ops = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--max-rows N] [--ops K]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (ops == 0) {
+        std::fprintf(stderr, "--ops must be greater than zero\n");
+        return 1;
+    }
+
+    std::printf("%10s %10s %10s %10s %10s %10s\n", "rows", "init", "transfer", "approve", "claim", "refund");
+    for (uint64_t rows = 10; rows <= max_rows; rows *= 10) {
+        try {
+            const result total = run(rows, ops);
+            std::printf("%10llu %10lld %10lld %10lld %10lld %10lld\n",
+                static_cast<unsigned long long>(rows),
+                static_cast<long long>(total.init / static_cast<int64_t>(ops)),
+                static_cast<long long>(total.transfer / static_cast<int64_t>(ops)),
+                static_cast<long long>(total.approve / static_cast<int64_t>(ops)),
+                static_cast<long long>(total.claim / static_cast<int64_t>(ops)),
+                static_cast<long long>(total.refund / static_cast<int64_t>(ops)));
+        } catch (const eosio::host::assertion_failure& e) {
+            std::fprintf(stderr, "benchmark failed at %llu rows: %s\n", static_cast<unsigned long long>(rows), e.what());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,490 @@
+// Load generator of escrow.bos against a local nodeos (see tests/restart.sh)
+//
+//   escrow_loadgen [--url URL] [--senders N] [--escrows-per-sender 1,10,100,1000] [--ops K]
+//                  [--mix init=1,transfer=1,approve=1,claim=1,refund=1] [--expiry SECONDS]
+//                  [--deps-dir DIR] [--contract-dir DIR] [--key PUBLIC_KEY] [--seed S] [--skip-setup]
+//
+// Deploys eosio.token & escrow.wasm, then for every number of escrows per sender pushes K actions of the mix
+// with cleos and reads the billed CPU, NET & RAM of each transaction from its trace
+// Prints one CSV row per (action, escrows per sender) with percentiles to stdout, progress goes to stderr
+//
+// The wallet must be unlocked with the key of `--key` imported, as for tests/contract_spec.rb
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    const string CONTRACT = "escrow.bos";
+    const string TOKEN = "eosio.token";
+    const string RECEIVER = "lgreceiver";
+    const string APPROVER = "lgapprover";
+    const vector<string> ACTIONS = {"init", "transfer", "approve", "claim", "refund"};
+
+    struct options {
+        string url = "http://127.0.0.1:8888";
+        string deps_dir = "tests/contract-shared-dependencies";
+        string contract_dir = ".";
+        string key = "EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV";
+        uint32_t senders = 4;
+        vector<uint64_t> escrows_per_sender = {1, 10, 100, 1000};
+        uint64_t ops = 200;
+        std::map<string, uint32_t> mix = {{"init", 1}, {"transfer", 1}, {"approve", 1}, {"claim", 1}, {"refund", 1}};
+        uint32_t expiry = 3;
+        uint32_t seed = 1;
+        bool skip_setup = false;
+    };
+
+    // Resources billed for one transaction, as reported in its trace
+    struct usage {
+        int64_t cpu_us = 0;
+        int64_t net_bytes = 0;
+        int64_t ram_bytes = 0;
+    };
+
+    struct command_result {
+        int status;
+        string output;
+    };
+
+    command_result run( const string& command ) {
+        command_result result{-1, ""};
+        FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+        if (pipe == nullptr) {
+            return result;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            result.output.append(buffer, read);
+        }
+        result.status = pclose(pipe);
+        return result;
+    }
+
+    // Single quotes for the shell, cleos takes the action data as one JSON argument
+    string quote( const string& str ) {
+        string quoted = "'";
+        for (const char c : str) {
+            quoted += c == '\'' ? string("'\\''") : string(1, c);
+        }
+        return quoted + "'";
+    }
+
+    // First number following `"key":`, enough for the flat fields of a cleos trace
+    bool find_number( const string& json, const string& key, size_t from, int64_t& value, size_t* end = nullptr ) {
+        const string pattern = "\"" + key + "\":";
+        const size_t pos = json.find(pattern, from);
+        if (pos == string::npos) {
+            return false;
+        }
+        char* parsed_end = nullptr;
+        const char* start = json.c_str() + pos + pattern.size();
+        value = std::strtoll(start, &parsed_end, 10);
+        if (end != nullptr) {
+            *end = parsed_end - json.c_str();
+        }
+        return parsed_end != start;
+    }
+
+    // Sum of the `account_ram_deltas` of every action of the transaction
+    int64_t ram_delta( const string& json ) {
+        int64_t total = 0;
+        size_t pos = 0;
+        while ((pos = json.find("\"account_ram_deltas\":[", pos)) != string::npos) {
+            const size_t list_end = json.find(']', pos);
+            size_t cursor = pos;
+            int64_t delta;
+            size_t delta_end;
+            while (find_number(json, "delta", cursor, delta, &delta_end) && delta_end < list_end) {
+                total += delta;
+                cursor = delta_end;
+            }
+            pos = list_end;
+        }
+        return total;
+    }
+
+    class cleos {
+        public:
+            explicit cleos( string url ) : url(std::move(url)) {}
+
+            command_result exec( const string& args ) const {
+                return run("cleos -u " + url + " " + args);
+            }
+
+            // Pushes an action & reads its billed resources, false when the transaction failed
+            bool push( const string& contract, const string& action, const string& data, const string& actor, usage& used, string& error ) const {
+                const auto result = exec("push action " + contract + " " + action + " " + quote(data) + " -p " + actor + " -j");
+                int64_t net_words = 0;
+                if (result.status != 0
+                    || !find_number(result.output, "cpu_usage_us", 0, used.cpu_us)
+                    || !find_number(result.output, "net_usage_words", 0, net_words)) {
+                    error = result.output.substr(0, 300);
+                    return false;
+                }
+                used.net_bytes = net_words * 8;
+                used.ram_bytes = ram_delta(result.output);
+                return true;
+            }
+
+            // Setup steps may have run before against the same chain, failures are reported & ignored
+            void setup( const string& args ) const {
+                const auto result = exec(args);
+                if (result.status != 0) {
+                    std::fprintf(stderr, "setup: cleos %s\n  %s\n", args.c_str(), result.output.substr(0, 200).c_str());
+                }
+            }
+
+            // Setup steps the measurements depend on, a failure ends the run with `hint`
+            void require( const string& args, const string& hint ) const {
+                const auto result = exec(args);
+                if (result.status != 0 && result.output.find("already running this version") == string::npos) {
+                    std::fprintf(stderr, "setup failed: cleos %s\n  %s\n%s\n", args.c_str(), result.output.substr(0, 300).c_str(), hint.c_str());
+                    std::exit(1);
+                }
+            }
+
+        private:
+            string url;
+    };
+
+    string utc_string( const std::time_t time ) {
+        char buffer[32];
+        std::tm tm{};
+        gmtime_r(&time, &tm);
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+        return buffer;
+    }
+
+    string sender_name( uint32_t i ) {
+        static const char* digits = "12345abcdefghijklmnopqrstuvwxyz";
+        return string("lgsender") + digits[i % 31] + digits[(i / 31) % 31];
+    }
+
+    // Unique escrow name of the i-th escrow, "lg" followed by i in base 31
+    string escrow_name( uint64_t i ) {
+        static const char* digits = "12345abcdefghijklmnopqrstuvwxyz";
+        string str = "lg";
+        do {
+            str += digits[i % 31];
+            i /= 31;
+        } while (i > 0);
+        return str;
+    }
+
+    string token_amount( uint64_t units ) {
+        std::ostringstream os;
+        os << units << ".0000 BOS";
+        return os.str();
+    }
+
+    // Escrow created by the generator, `expires_at` is the wall clock time its refund opens
+    struct escrow_state {
+        string name;
+        string sender;
+        std::time_t expires_at;
+    };
+
+    struct samples {
+        vector<int64_t> cpu;
+        vector<int64_t> net;
+        vector<int64_t> ram;
+        uint64_t failed = 0;
+    };
+
+    int64_t percentile( vector<int64_t> values, double p ) {
+        if (values.empty()) {
+            return 0;
+        }
+        std::sort(values.begin(), values.end());
+        const size_t rank = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[rank];
+    }
+
+    class generator {
+        public:
+            generator( const options& opts ) : opts(opts), chain(opts.url), rng(opts.seed) {
+                for (uint32_t i = 0; i < opts.senders; ++i) {
+                    senders.push_back(sender_name(i));
+                }
+            }
+
+            void setup() {
+                vector<string> accounts = {TOKEN, CONTRACT, RECEIVER, APPROVER};
+                accounts.insert(accounts.end(), senders.begin(), senders.end());
+                for (const auto& account : accounts) {
+                    chain.setup("create account eosio " + account + " " + opts.key + " " + opts.key);
+                }
+
+                chain.setup("set contract " + TOKEN + " " + opts.deps_dir + "/eosio.token -p " + TOKEN);
+                chain.setup("push action " + TOKEN + " create " + quote("[\"eosio\",\"10000000000.0000 BOS\"]") + " -p " + TOKEN);
+                chain.setup("push action " + TOKEN + " issue " + quote("[\"eosio\",\"1000000000.0000 BOS\",\"escrow load\"]") + " -p eosio");
+                for (const auto& sender : senders) {
+                    chain.setup("transfer eosio " + sender + " " + quote(token_amount(10000000)) + " -p eosio");
+                }
+
+                // The checked-in escrow.wasm & escrow.abi predate `setconfig`, deploy a build of the current sources
+                const string rebuild = "build escrow.wasm & escrow.abi from the current sources with ./build.sh, or pass --contract-dir";
+                std::ifstream abi(opts.contract_dir + "/escrow.abi");
+                const string abi_json((std::istreambuf_iterator<char>(abi)), std::istreambuf_iterator<char>());
+                if (abi_json.find("\"setconfig\"") == string::npos) {
+                    std::fprintf(stderr, "%s/escrow.abi has no setconfig action, %s\n", opts.contract_dir.c_str(), rebuild.c_str());
+                    std::exit(1);
+                }
+
+                chain.require("set contract " + CONTRACT + " " + opts.contract_dir + " escrow.wasm escrow.abi -p " + CONTRACT, rebuild);
+                chain.setup("set account permission " + CONTRACT + " active " + quote(
+                    "{\"threshold\":1,\"keys\":[{\"key\":\"" + opts.key + "\",\"weight\":1}],"
+                    "\"accounts\":[{\"permission\":{\"actor\":\"" + CONTRACT + "\",\"permission\":\"eosio.code\"},\"weight\":1}]}")
+                    + " owner -p " + CONTRACT + "@owner");
+
+                string sender_list;
+                for (const auto& sender : senders) {
+                    sender_list += (sender_list.empty() ? "\"" : ",\"") + sender + "\"";
+                }
+                chain.require("push action " + CONTRACT + " setconfig " + quote(
+                    "{\"senders\":[" + sender_list + "],\"approvers\":[\"" + APPROVER + "\"],"
+                    "\"token_contract\":\"" + TOKEN + "\",\"token_symbol\":\"4,BOS\",\"max_expiry\":15552000}")
+                    + " -p " + CONTRACT, rebuild);
+            }
+
+            // Grows every sender to `per_sender` funded escrows expiring far away, these rows are only there to fill the tables
+            void prefill( uint64_t per_sender ) {
+                for (const auto& sender : senders) {
+                    while (prefilled[sender] < per_sender) {
+                        const string name = escrow_name(next_escrow++);
+                        usage used;
+                        string error;
+                        if (!init(sender, name, std::time(nullptr) + 30 * 24 * 60 * 60, used, error)
+                            || !transfer(sender, name, used, error)) {
+                            std::fprintf(stderr, "prefill failed: %s\n", error.c_str());
+                            std::exit(1);
+                        }
+                        ++prefilled[sender];
+                    }
+                }
+            }
+
+            // Pushes `ops` actions of the mix, each action is drawn among the ones possible in the current state
+            std::map<string, samples> run_mix( uint64_t ops ) {
+                std::map<string, samples> results;
+                for (uint64_t i = 0; i < ops; ++i) {
+                    const string action = draw();
+                    usage used;
+                    string error;
+                    const bool ok = step(action, used, error);
+
+                    auto& s = results[action];
+                    if (!ok) {
+                        ++s.failed;
+                        std::fprintf(stderr, "%s failed: %s\n", action.c_str(), error.c_str());
+                        continue;
+                    }
+                    s.cpu.push_back(used.cpu_us);
+                    s.net.push_back(used.net_bytes);
+                    s.ram.push_back(used.ram_bytes);
+                }
+                return results;
+            }
+
+        private:
+            const options& opts;
+            cleos chain;
+            std::mt19937 rng;
+            vector<string> senders;
+            std::map<string, uint64_t> prefilled;
+            uint64_t next_escrow = 0;
+
+            vector<escrow_state> empty;
+            vector<escrow_state> funded;
+            vector<escrow_state> approved;
+
+            bool init( const string& sender, const string& name, std::time_t expires_at, usage& used, string& error ) {
+                return chain.push(CONTRACT, "init",
+                    "{\"sender\":\"" + sender + "\",\"receiver\":\"" + RECEIVER + "\",\"approver\":\"" + APPROVER + "\","
+                    "\"escrow_name\":\"" + name + "\",\"expires_at\":\"" + utc_string(expires_at) + "\",\"memo\":\"escrow load\"}",
+                    sender, used, error);
+            }
+
+            bool transfer( const string& sender, const string& memo, usage& used, string& error ) {
+                return chain.push(TOKEN, "transfer",
+                    "{\"from\":\"" + sender + "\",\"to\":\"" + CONTRACT + "\",\"quantity\":\"1.0000 BOS\",\"memo\":\"" + memo + "\"}",
+                    sender, used, error);
+            }
+
+            bool possible( const string& action ) const {
+                if (action == "transfer") return !empty.empty();
+                if (action == "approve") return !funded.empty();
+                if (action == "claim") return !approved.empty();
+                if (action == "refund") return std::any_of(funded.begin(), funded.end(), [](const escrow_state& e) { return std::time(nullptr) > e.expires_at; });
+                return true;
+            }
+
+            string draw() {
+                vector<string> actions;
+                vector<uint32_t> weights;
+                for (const auto& [action, weight] : opts.mix) {
+                    if (weight > 0 && possible(action)) {
+                        actions.push_back(action);
+                        weights.push_back(weight);
+                    }
+                }
+                if (actions.empty()) {
+                    return "init";
+                }
+                std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+                return actions[pick(rng)];
+            }
+
+            static escrow_state take( vector<escrow_state>& from, size_t index ) {
+                escrow_state e = from[index];
+                from.erase(from.begin() + index);
+                return e;
+            }
+
+            bool step( const string& action, usage& used, string& error ) {
+                if (action == "init") {
+                    escrow_state e{escrow_name(next_escrow++), senders[rng() % senders.size()], std::time(nullptr) + opts.expiry};
+                    if (!init(e.sender, e.name, e.expires_at, used, error)) return false;
+                    empty.push_back(e);
+                    return true;
+                }
+                if (action == "transfer") {
+                    escrow_state e = take(empty, rng() % empty.size());
+                    // The only empty escrow of a sender is funded without memo, through the `byfunded` lookup
+                    const bool only_empty = std::none_of(empty.begin(), empty.end(), [&](const escrow_state& other) { return other.sender == e.sender; });
+                    if (!transfer(e.sender, only_empty ? "" : e.name, used, error)) return false;
+                    funded.push_back(e);
+                    return true;
+                }
+                if (action == "approve") {
+                    escrow_state e = take(funded, rng() % funded.size());
+                    if (!chain.push(CONTRACT, "approve", "{\"escrow_name\":\"" + e.name + "\",\"approver\":\"" + APPROVER + "\"}", APPROVER, used, error)) return false;
+                    approved.push_back(e);
+                    return true;
+                }
+                if (action == "claim") {
+                    escrow_state e = take(approved, rng() % approved.size());
+                    return chain.push(CONTRACT, "claim", "{\"escrow_name\":\"" + e.name + "\"}", RECEIVER, used, error);
+                }
+                // refund, of a funded escrow past its expiry
+                const auto now = std::time(nullptr);
+                const auto itr = std::find_if(funded.begin(), funded.end(), [&](const escrow_state& e) { return now > e.expires_at; });
+                escrow_state e = take(funded, itr - funded.begin());
+                return chain.push(CONTRACT, "refund", "{\"escrow_name\":\"" + e.name + "\"}", e.sender, used, error);
+            }
+    };
+
+    vector<uint64_t> parse_list( const string& str ) {
+        vector<uint64_t> values;
+        std::istringstream is(str);
+        string item;
+        while (std::getline(is, item, ',')) {
+            values.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        }
+        return values;
+    }
+
+    bool parse_mix( const string& str, std::map<string, uint32_t>& mix ) {
+        mix.clear();
+        std::istringstream is(str);
+        string item;
+        while (std::getline(is, item, ',')) {
+            const size_t eq = item.find('=');
+            const string action = item.substr(0, eq);
+            if (eq == string::npos || std::find(ACTIONS.begin(), ACTIONS.end(), action) == ACTIONS.end()) {
+                return false;
+            }
+            mix[action] = std::strtoul(item.c_str() + eq + 1, nullptr, 10);
+        }
+        return !mix.empty();
+    }
+
+    int usage_error( const char* program ) {
+        std::fprintf(stderr,
+            "usage: %s [--url URL] [--senders N] [--escrows-per-sender 1,10,100] [--ops K]\n"
+            "          [--mix init=1,transfer=1,approve=1,claim=1,refund=1] [--expiry SECONDS]\n"
+            "          [--deps-dir DIR] [--contract-dir DIR] [--key PUBLIC_KEY] [--seed S] [--skip-setup]\n", program);
+        return 1;
+    }
+}
+
+int main( int argc, char** argv ) {
+    options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--skip-setup") {
+            opts.skip_setup = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return usage_error(argv[0]);
+        }
+        const string value = argv[++i];
+        if (arg == "--url") opts.url = value;
+        else if (arg == "--senders") opts.senders = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--escrows-per-sender") opts.escrows_per_sender = parse_list(value);
+        else if (arg == "--ops") opts.ops = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--mix") { if (!parse_mix(value, opts.mix)) return usage_error(argv[0]); }
+        else if (arg == "--expiry") opts.expiry = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--deps-dir") opts.deps_dir = value;
+        else if (arg == "--contract-dir") opts.contract_dir = value;
+        else if (arg == "--key") opts.key = value;
+        else if (arg == "--seed") opts.seed = std::strtoul(value.c_str(), nullptr, 10);
+        else return usage_error(argv[0]);
+    }
+
+    if (opts.senders == 0 || opts.senders > 31 * 31 || opts.escrows_per_sender.empty()) {
+        return usage_error(argv[0]);
+    }
+
+    if (run("cleos version client").status != 0) {
+        std::fprintf(stderr, "cleos is not available, start nodeos with tests/restart.sh & unlock the wallet\n");
+        return 1;
+    }
+
+    generator gen(opts);
+    if (!opts.skip_setup) {
+        gen.setup();
+    }
+
+    std::printf("action,escrows_per_sender,samples,failed,cpu_us_p50,cpu_us_p90,cpu_us_p99,cpu_us_max,net_bytes_p50,net_bytes_p99,ram_bytes_p50,ram_bytes_p99\n");
+    std::sort(opts.escrows_per_sender.begin(), opts.escrows_per_sender.end());
+    for (const uint64_t per_sender : opts.escrows_per_sender) {
+        std::fprintf(stderr, "%llu escrows per sender\n", static_cast<unsigned long long>(per_sender));
+        gen.prefill(per_sender);
+
+        for (const auto& [action, s] : gen.run_mix(opts.ops)) {
+            std::printf("%s,%llu,%zu,%llu,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld\n",
+                action.c_str(),
+                static_cast<unsigned long long>(per_sender),
+                s.cpu.size(),
+                static_cast<unsigned long long>(s.failed),
+                static_cast<long long>(percentile(s.cpu, 0.50)),
+                static_cast<long long>(percentile(s.cpu, 0.90)),
+                static_cast<long long>(percentile(s.cpu, 0.99)),
+                static_cast<long long>(percentile(s.cpu, 1.0)),
+                static_cast<long long>(percentile(s.net, 0.50)),
+                static_cast<long long>(percentile(s.net, 0.99)),
+                static_cast<long long>(percentile(s.ram, 0.50)),
+                static_cast<long long>(percentile(s.ram, 0.99)));
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
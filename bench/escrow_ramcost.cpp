@@ -0,0 +1,284 @@
+// Billed RAM of one escrow for each row layout, across memo lengths & approval counts
+//
+//   escrow_ramcost [--memo 0,16,64,256] [--approvals 0,1,2] [--tranches 4] [--tokens 1] [--detail]
+//
+// Sizes are the packed sizes of the ABI serialization (fixed-width integers, varuint32 length of strings & vectors)
+// plus the overheads nodeos bills for every row, secondary index entry & table (see `billable_size` in nodeos)
+// A layout is the list of rows one escrow adds, a proposed layout is compared by adding it to `layouts()`
+// Rows of the current layouts are sized from the row types of include/escrow.hpp, the legacy ones by hand
+
+#include <escrow.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    // nodeos `config::billable_size_v`, key_value_object & index64_object/index128_object & table_id_object
+    constexpr uint64_t ROW_OVERHEAD = 108;
+    constexpr uint64_t INDEX64_OVERHEAD = 128;
+    constexpr uint64_t INDEX128_OVERHEAD = 136;
+    constexpr uint64_t TABLE_OVERHEAD = 108;
+
+    // Packed sizes of the contract types
+    constexpr uint64_t NAME = 8;
+    constexpr uint64_t UINT8 = 1;
+    constexpr uint64_t BOOL = 1;
+    constexpr uint64_t TIME_POINT_SEC = 4;
+    constexpr uint64_t ASSET = 8 + 8;
+    constexpr uint64_t EXTENDED_ASSET = ASSET + NAME;
+
+    uint64_t varuint32_size( uint64_t value ) {
+        uint64_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    uint64_t string_size( const uint64_t length ) {
+        return varuint32_size(length) + length;
+    }
+
+    uint64_t vector_size( const uint64_t count, const uint64_t element_size ) {
+        return varuint32_size(count) + count * element_size;
+    }
+
+    uint64_t pack_size( const name& ) { return NAME; }
+    uint64_t pack_size( const uint8_t ) { return UINT8; }
+    uint64_t pack_size( const bool ) { return BOOL; }
+    uint64_t pack_size( const int64_t ) { return 8; }
+    uint64_t pack_size( const uint64_t ) { return 8; }
+    uint64_t pack_size( const time_point_sec& ) { return TIME_POINT_SEC; }
+    uint64_t pack_size( const extended_asset& ) { return EXTENDED_ASSET; }
+    uint64_t pack_size( const string& str ) { return string_size(str.size()); }
+
+    // The structured bindings stop the build when a row of include/escrow.hpp gains or loses a field
+    uint64_t pack_size( const escrow::tranche& tr ) {
+        const auto& [amount, unlock_at, approvals, claimed] = tr;
+        return pack_size(amount) + pack_size(unlock_at) + pack_size(approvals) + pack_size(claimed);
+    }
+
+    template<typename T>
+    uint64_t pack_size( const vector<T>& items ) {
+        uint64_t size = varuint32_size(items.size());
+        for (const auto& item : items) {
+            size += pack_size(item);
+        }
+        return size;
+    }
+
+    uint64_t pack_size( const escrow::escrow_row& row ) {
+        const auto& [escrow_name, sender, approver, approvals, ext_asset, created_at, locked, kind] = row;
+        return pack_size(escrow_name) + pack_size(sender) + pack_size(approver) + pack_size(approvals)
+            + pack_size(ext_asset) + pack_size(created_at) + pack_size(locked) + pack_size(kind);
+    }
+
+    uint64_t pack_size( const escrow::directory_row& row ) {
+        const auto& [escrow_name, sender, receiver, expires_at] = row;
+        return pack_size(escrow_name) + pack_size(sender) + pack_size(receiver) + pack_size(expires_at);
+    }
+
+    uint64_t pack_size( const escrow::memo_row& row ) {
+        const auto& [escrow_name, memo] = row;
+        return pack_size(escrow_name) + pack_size(memo);
+    }
+
+    uint64_t pack_size( const escrow::schedule_row& row ) {
+        const auto& [escrow_name, tranches] = row;
+        return pack_size(escrow_name) + pack_size(tranches);
+    }
+
+    uint64_t pack_size( const escrow::vesting_row& row ) {
+        const auto& [escrow_name, start_at, end_at, claimed] = row;
+        return pack_size(escrow_name) + pack_size(start_at) + pack_size(end_at) + pack_size(claimed);
+    }
+
+    uint64_t pack_size( const escrow::stats_row& row ) {
+        const auto& [open, funded, approved, locked, held] = row;
+        return pack_size(open) + pack_size(funded) + pack_size(approved) + pack_size(locked) + pack_size(held);
+    }
+
+    // Escrow a layout is sized for, `tranches` only applies to milestone escrows
+    struct escrow_shape {
+        uint64_t memo_length;
+        uint64_t approvals;
+        uint64_t tranches;
+    };
+
+    // One row added by an escrow, `packed` is its serialized size
+    struct row_cost {
+        string table;
+        uint64_t packed;
+        uint64_t index64 = 0;
+        uint64_t index128 = 0;
+
+        uint64_t billed() const { return packed + ROW_OVERHEAD + index64 * INDEX64_OVERHEAD + index128 * INDEX128_OVERHEAD; }
+    };
+
+    struct layout {
+        string name;
+        string description;
+        vector<row_cost> (*rows)(const escrow_shape& shape);
+
+        // Tables, with the tables of their secondary indexes, created by the first escrow of a new scope
+        uint64_t tables_per_scope;
+    };
+
+    // Baseline escrow_row: memo & approvals in the row, `bysender` index, every escrow in the scope of the contract
+    vector<row_cost> legacy_rows( const escrow_shape& shape ) {
+        return {
+            {"escrows", NAME * 4 + vector_size(shape.approvals, NAME) + EXTENDED_ASSET + string_size(shape.memo_length) + TIME_POINT_SEC * 2 + BOOL, 1},
+        };
+    }
+
+    // Approvals as a bitmask & memo in `escrowmemo`, still a single `escrows` table with `bysender`
+    vector<row_cost> cold_memo_rows( const escrow_shape& shape ) {
+        return {
+            {"escrows", NAME * 4 + UINT8 + EXTENDED_ASSET + TIME_POINT_SEC * 2 + BOOL, 1},
+            {"escrowmemo", NAME + string_size(shape.memo_length)},
+        };
+    }
+
+    // Current layout of include/escrow.hpp: fixed-size `escrows` row in the scope of the sender, `escrowdir` & `escrowmemo`
+    vector<row_cost> current_rows( const escrow_shape& shape ) {
+        escrow::memo_row memo{};
+        memo.memo.assign(shape.memo_length, 'm');
+        return {
+            {"escrows", pack_size(escrow::escrow_row{}), 1},
+            {"escrowdir", pack_size(escrow::directory_row{}), 2},
+            {"escrowmemo", pack_size(memo)},
+        };
+    }
+
+    // Milestone escrow of the current layout, its tranches in `schedules`
+    vector<row_cost> milestone_rows( const escrow_shape& shape ) {
+        escrow::schedule_row schedule{};
+        schedule.tranches.resize(shape.tranches);
+        auto rows = current_rows(shape);
+        rows.push_back({"schedules", pack_size(schedule)});
+        return rows;
+    }
+
+    // Vesting escrow of the current layout, its schedule in `vestings`
+    vector<row_cost> vesting_rows( const escrow_shape& shape ) {
+        auto rows = current_rows(shape);
+        rows.push_back({"vestings", pack_size(escrow::vesting_row{})});
+        return rows;
+    }
+
+    const vector<layout>& layouts() {
+        static const vector<layout> all = {
+            {"legacy", "baseline escrow_row with memo, approvals vector & bysender", legacy_rows, 0},
+            {"coldmemo", "bitmask approvals, memo in escrowmemo, bysender", cold_memo_rows, 0},
+            {"current", "sender-scoped escrows + byfunded, escrowdir + byexpiry & byreceiver, escrowmemo", current_rows, 2},
+            {"milestone", "current + schedules", milestone_rows, 2},
+            {"vesting", "current + vestings", vesting_rows, 2},
+        };
+        return all;
+    }
+
+    uint64_t total_billed( const vector<row_cost>& rows ) {
+        uint64_t total = 0;
+        for (const auto& row : rows) {
+            total += row.billed();
+        }
+        return total;
+    }
+
+    vector<uint64_t> parse_list( const string& str ) {
+        vector<uint64_t> values;
+        std::istringstream is(str);
+        string item;
+        while (std::getline(is, item, ',')) {
+            values.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        }
+        return values;
+    }
+}
+
+int main( int argc, char** argv ) {
+    vector<uint64_t> memo_lengths = {0, 16, 64, 128, 256};
+    vector<uint64_t> approval_counts = {0, 1, 2};
+    uint64_t tranches = 4;
+    uint64_t tokens = 1;
+    bool detail = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--detail") == 0) {
+            detail = true;
+        } else if (std::strcmp(argv[i], "--memo") == 0 && i + 1 < argc) {
+            memo_lengths = parse_list(argv[++i]);
+        } else if (std::strcmp(argv[i], "--approvals") == 0 && i + 1 < argc) {
+            approval_counts = parse_list(argv[++i]);
+        } else if (std::strcmp(argv[i], "--tranches") == 0 && i + 1 < argc) {
+            tranches = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--tokens") == 0 && i + 1 < argc) {
+            tokens = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--memo 0,16,64,256] [--approvals 0,1,2] [--tranches 4] [--tokens 1] [--detail]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (const auto& l : layouts()) {
+        std::printf("%-10s %s\n", l.name.c_str(), l.description.c_str());
+    }
+    std::printf("\nbilled bytes per escrow, %llu tranches per milestone escrow\n%6s %9s", static_cast<unsigned long long>(tranches), "memo", "approvals");
+    for (const auto& l : layouts()) {
+        std::printf(" %10s", l.name.c_str());
+    }
+    std::printf("\n");
+
+    for (const uint64_t memo_length : memo_lengths) {
+        for (const uint64_t approvals : approval_counts) {
+            std::printf("%6llu %9llu", static_cast<unsigned long long>(memo_length), static_cast<unsigned long long>(approvals));
+            for (const auto& l : layouts()) {
+                std::printf(" %10llu", static_cast<unsigned long long>(total_billed(l.rows({memo_length, approvals, tranches}))));
+            }
+            std::printf("\n");
+        }
+    }
+
+    std::printf("\nbilled bytes per new scope (first escrow of a sender)\n");
+    for (const auto& l : layouts()) {
+        std::printf("%-10s %10llu\n", l.name.c_str(), static_cast<unsigned long long>(l.tables_per_scope * TABLE_OVERHEAD));
+    }
+
+    // `stats` is a single row of the contract, `held` has one entry per token held in escrows
+    escrow::stats_row stats{};
+    stats.held.resize(tokens);
+    std::printf("\nbilled bytes per contract, %llu tokens held\n%-10s %10llu\n",
+        static_cast<unsigned long long>(tokens), "stats",
+        static_cast<unsigned long long>(pack_size(stats) + ROW_OVERHEAD + TABLE_OVERHEAD));
+
+    if (detail) {
+        for (const auto& l : layouts()) {
+            std::printf("\n%s\n%12s %6s %9s %8s %8s %8s %8s\n", l.name.c_str(), "table", "memo", "approvals", "packed", "row", "indexes", "billed");
+            for (const uint64_t memo_length : memo_lengths) {
+                for (const uint64_t approvals : approval_counts) {
+                    for (const auto& row : l.rows({memo_length, approvals, tranches})) {
+                        std::printf("%12s %6llu %9llu %8llu %8llu %8llu %8llu\n",
+                            row.table.c_str(),
+                            static_cast<unsigned long long>(memo_length),
+                            static_cast<unsigned long long>(approvals),
+                            static_cast<unsigned long long>(row.packed),
+                            static_cast<unsigned long long>(ROW_OVERHEAD),
+                            static_cast<unsigned long long>(row.index64 * INDEX64_OVERHEAD + row.index128 * INDEX128_OVERHEAD),
+                            static_cast<unsigned long long>(row.billed()));
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,376 @@
+// Per-function code size & static instruction counts of escrow.wasm
+//
+//   escrow_wasm_profile [--label L] [--output FILE] [escrow.wasm]
+//
+// Reads the code section of the module & names functions from its `name` section (demangled), else from its exports
+// Prints one CSV row per defined function, largest first, `--label` (e.g. a commit id) is repeated in the first
+// column so the profiles of several commits append into one file
+// Counts are static: every instruction of the body counts once, whether or not an action runs it
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    struct reader {
+        const uint8_t* pos;
+        const uint8_t* end;
+
+        uint8_t byte() {
+            if (pos >= end) {
+                throw std::runtime_error("unexpected end of module");
+            }
+            return *pos++;
+        }
+
+        uint64_t uleb() {
+            uint64_t value = 0;
+            for (int shift = 0;; shift += 7) {
+                const uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if ((b & 0x80) == 0) {
+                    return value;
+                }
+            }
+        }
+
+        // Signed immediates are only skipped, their value is never needed
+        void sleb() {
+            while (byte() & 0x80) {
+            }
+        }
+
+        void skip( const uint64_t count ) {
+            if (count > static_cast<uint64_t>(end - pos)) {
+                throw std::runtime_error("unexpected end of module");
+            }
+            pos += count;
+        }
+
+        string str() {
+            const uint64_t length = uleb();
+            const char* start = reinterpret_cast<const char*>(pos);
+            skip(length);
+            return string(start, length);
+        }
+    };
+
+    struct function_profile {
+        uint32_t index = 0;
+        string name;
+        uint64_t code_bytes = 0;
+        uint64_t instructions = 0;
+        uint64_t calls = 0;
+        uint64_t memory_ops = 0;
+        uint64_t float_ops = 0;
+        std::set<uint32_t> called;
+        string intrinsics;
+    };
+
+    bool is_float_op( const uint8_t op ) {
+        return op == 0x2a || op == 0x2b || op == 0x38 || op == 0x39   // f32/f64 load & store
+            || op == 0x43 || op == 0x44                                // f32/f64 const
+            || (op >= 0x5b && op <= 0x66)                              // f32/f64 comparisons
+            || (op >= 0x8b && op <= 0xa6)                              // f32/f64 arithmetic
+            || (op >= 0xa8 && op <= 0xab) || (op >= 0xae && op <= 0xbf); // conversions from & to floats
+    }
+
+    // Decodes one function body, instructions are counted with their immediates skipped
+    void profile_body( reader body, function_profile& profile ) {
+        const uint64_t local_groups = body.uleb();
+        for (uint64_t i = 0; i < local_groups; ++i) {
+            body.uleb();
+            body.byte();
+        }
+
+        while (body.pos < body.end) {
+            const uint8_t op = body.byte();
+            ++profile.instructions;
+
+            if (is_float_op(op)) {
+                ++profile.float_ops;
+            }
+            if (op >= 0x28 && op <= 0x3e) {
+                ++profile.memory_ops;
+            }
+
+            switch (op) {
+                case 0x02: case 0x03: case 0x04:    // block, loop, if
+                    body.sleb();
+                    break;
+                case 0x0c: case 0x0d:               // br, br_if
+                case 0x20: case 0x21: case 0x22:    // local.get, local.set, local.tee
+                case 0x23: case 0x24:               // global.get, global.set
+                case 0x25: case 0x26:               // table.get, table.set
+                case 0xd2:                          // ref.func
+                    body.uleb();
+                    break;
+                case 0x0e: {                        // br_table
+                    const uint64_t targets = body.uleb();
+                    for (uint64_t i = 0; i <= targets; ++i) {
+                        body.uleb();
+                    }
+                    break;
+                }
+                case 0x10:                          // call
+                    ++profile.calls;
+                    profile.called.insert(body.uleb());
+                    break;
+                case 0x11:                          // call_indirect
+                    ++profile.calls;
+                    body.uleb();
+                    body.uleb();
+                    break;
+                case 0x1c: {                        // select t
+                    const uint64_t types = body.uleb();
+                    body.skip(types);
+                    break;
+                }
+                case 0x28: case 0x29: case 0x2a: case 0x2b: case 0x2c: case 0x2d: case 0x2e: case 0x2f:
+                case 0x30: case 0x31: case 0x32: case 0x33: case 0x34: case 0x35: case 0x36: case 0x37:
+                case 0x38: case 0x39: case 0x3a: case 0x3b: case 0x3c: case 0x3d: case 0x3e:
+                    body.uleb();                    // loads & stores, alignment & offset
+                    body.uleb();
+                    break;
+                case 0x3f: case 0x40:               // memory.size, memory.grow
+                case 0xd0:                          // ref.null
+                    body.byte();
+                    break;
+                case 0x41: case 0x42:               // i32.const, i64.const
+                    body.sleb();
+                    break;
+                case 0x43:                          // f32.const
+                    body.skip(4);
+                    break;
+                case 0x44:                          // f64.const
+                    body.skip(8);
+                    break;
+                case 0xfc: {                        // saturating truncations & bulk memory
+                    const uint64_t sub = body.uleb();
+                    if (sub == 10) {                // memory.copy
+                        ++profile.memory_ops;
+                        body.skip(2);
+                    } else if (sub == 11) {         // memory.fill
+                        ++profile.memory_ops;
+                        body.skip(1);
+                    } else if (sub == 8) {          // memory.init
+                        body.uleb();
+                        body.skip(1);
+                    } else if (sub == 12 || sub == 14) {
+                        body.uleb();
+                        body.uleb();
+                    } else if (sub == 9 || sub == 13 || (sub >= 15 && sub <= 17)) {
+                        body.uleb();
+                    } else if (sub > 7) {
+                        throw std::runtime_error("unknown 0xfc instruction " + std::to_string(sub));
+                    }
+                    break;
+                }
+                default:
+                    // Remaining valid opcodes have no immediate
+                    if (!(op <= 0x01 || op == 0x05 || op == 0x0b || op == 0x0f || op == 0x1a || op == 0x1b
+                        || (op >= 0x45 && op <= 0xc4) || op == 0xd1)) {
+                        throw std::runtime_error("unknown instruction " + std::to_string(op));
+                    }
+                    break;
+            }
+        }
+    }
+
+    string demangle( const string& name ) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+        if (status != 0 || demangled == nullptr) {
+            return name;
+        }
+        string result = demangled;
+        std::free(demangled);
+        return result;
+    }
+
+    vector<function_profile> profile_module( const vector<uint8_t>& wasm ) {
+        reader module{wasm.data(), wasm.data() + wasm.size()};
+        if (wasm.size() < 8 || std::memcmp(wasm.data(), "\0asm", 4) != 0) {
+            throw std::runtime_error("not a wasm module");
+        }
+        module.skip(8);
+
+        uint32_t imported_functions = 0;
+        vector<string> imports;
+        std::map<uint32_t, string> names;
+        std::map<uint32_t, string> exports;
+        vector<function_profile> profiles;
+
+        while (module.pos < module.end) {
+            const uint8_t id = module.byte();
+            const uint64_t size = module.uleb();
+            reader section{module.pos, module.pos + size};
+            module.skip(size);
+
+            if (id == 2) {                          // imports, they come first in the function index space
+                const uint64_t count = section.uleb();
+                for (uint64_t i = 0; i < count; ++i) {
+                    section.str();
+                    const string field = section.str();
+                    const uint8_t kind = section.byte();
+                    if (kind == 0) {
+                        section.uleb();
+                        imports.push_back(field);
+                        ++imported_functions;
+                    } else if (kind == 1) {         // table: reftype & limits
+                        section.byte();
+                        if (section.byte() & 1) section.uleb();
+                        section.uleb();
+                    } else if (kind == 2) {         // memory: limits
+                        if (section.byte() & 1) section.uleb();
+                        section.uleb();
+                    } else {                        // global: valtype & mutability
+                        section.byte();
+                        section.byte();
+                    }
+                }
+            } else if (id == 7) {                   // exports
+                const uint64_t count = section.uleb();
+                for (uint64_t i = 0; i < count; ++i) {
+                    const string name = section.str();
+                    const uint8_t kind = section.byte();
+                    const uint64_t index = section.uleb();
+                    if (kind == 0) {
+                        exports[index] = name;
+                    }
+                }
+            } else if (id == 10) {                  // code
+                const uint64_t count = section.uleb();
+                for (uint64_t i = 0; i < count; ++i) {
+                    const uint64_t body_size = section.uleb();
+                    function_profile profile;
+                    profile.index = imported_functions + i;
+                    profile.code_bytes = body_size;
+                    profile_body(reader{section.pos, section.pos + body_size}, profile);
+                    section.skip(body_size);
+                    profiles.push_back(profile);
+                }
+            } else if (id == 0 && section.str() == "name") {
+                while (section.pos < section.end) {
+                    const uint8_t subsection = section.byte();
+                    const uint64_t subsection_size = section.uleb();
+                    reader content{section.pos, section.pos + subsection_size};
+                    section.skip(subsection_size);
+                    if (subsection != 1) {
+                        continue;
+                    }
+                    const uint64_t count = content.uleb();
+                    for (uint64_t i = 0; i < count; ++i) {
+                        const uint32_t index = content.uleb();
+                        names[index] = content.str();
+                    }
+                }
+            }
+        }
+
+        for (auto& profile : profiles) {
+            if (names.count(profile.index)) {
+                profile.name = demangle(names[profile.index]);
+            } else if (exports.count(profile.index)) {
+                profile.name = exports[profile.index];
+            } else {
+                profile.name = "f" + std::to_string(profile.index);
+            }
+
+            // Intrinsics called, e.g. `db_store_i64` or the softfloat `_eosio_f64_mul`, identify functions of a stripped module
+            for (const uint32_t index : profile.called) {
+                if (index < imported_functions) {
+                    profile.intrinsics += (profile.intrinsics.empty() ? "" : " ") + imports[index];
+                }
+            }
+        }
+        return profiles;
+    }
+
+    string csv_field( const string& value ) {
+        if (value.find_first_of(",\"") == string::npos) {
+            return value;
+        }
+        string quoted = "\"";
+        for (const char c : value) {
+            quoted += c == '"' ? string("\"\"") : string(1, c);
+        }
+        return quoted + "\"";
+    }
+}
+
+int main( int argc, char** argv ) {
+    string path = "escrow.wasm";
+    string label;
+    string output;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--label L] [--output FILE] [escrow.wasm]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "cannot read %s\n", path.c_str());
+        return 1;
+    }
+    const vector<uint8_t> wasm((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    vector<function_profile> profiles;
+    try {
+        profiles = profile_module(wasm);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+        return 1;
+    }
+
+    std::sort(profiles.begin(), profiles.end(), [](const function_profile& a, const function_profile& b) {
+        return a.code_bytes != b.code_bytes ? a.code_bytes > b.code_bytes : a.index < b.index;
+    });
+
+    FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+    if (out == nullptr) {
+        std::fprintf(stderr, "cannot write %s\n", output.c_str());
+        return 1;
+    }
+    std::fprintf(out, "label,index,function,code_bytes,instructions,calls,memory_ops,float_ops,intrinsics\n");
+    for (const auto& p : profiles) {
+        std::fprintf(out, "%s,%u,%s,%llu,%llu,%llu,%llu,%llu,%s\n",
+            csv_field(label).c_str(),
+            p.index,
+            csv_field(p.name).c_str(),
+            static_cast<unsigned long long>(p.code_bytes),
+            static_cast<unsigned long long>(p.instructions),
+            static_cast<unsigned long long>(p.calls),
+            static_cast<unsigned long long>(p.memory_ops),
+            static_cast<unsigned long long>(p.float_ops),
+            p.intrinsics.c_str());
+    }
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <eosio/name.hpp>
+
+#include <any>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+    struct permission_level {
+        name actor;
+        name permission;
+    };
+
+    // Inline action, `send` captures it on the host chain instead of scheduling it
+    struct action {
+        std::vector<permission_level> authorization;
+        eosio::name account;
+        eosio::name name;
+        std::any data;
+
+        action() = default;
+
+        template<typename T>
+        action( const permission_level& auth, eosio::name a, eosio::name n, T&& value )
+            : authorization{auth}, account(a), name(n), data(std::forward<T>(value)) {}
+
+        template<typename T>
+        T data_as() const { return std::any_cast<T>(data); }
+
+        void send() const;
+    };
+
+    void require_auth( name n );
+    bool has_auth( name n );
+    void require_recipient( name notify_account );
+    bool is_account( name n );
+    name current_receiver();
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <eosio/symbol.hpp>
+
+#include <tuple>
+
+namespace eosio {
+
+    // Same range & symbol checks as the CDT `eosio::asset`
+    struct asset {
+        static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+        int64_t amount = 0;
+        eosio::symbol symbol;
+
+        asset() = default;
+
+        asset( int64_t a, class symbol s ) : amount(a), symbol(s) {
+            check(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+            check(symbol.is_valid(), "invalid symbol name");
+        }
+
+        bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+        bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+        asset operator-() const {
+            asset r = *this;
+            r.amount = -r.amount;
+            return r;
+        }
+
+        asset& operator-=( const asset& a ) {
+            check(a.symbol == symbol, "attempt to subtract asset with different symbol");
+            amount -= a.amount;
+            check(-max_amount <= amount, "subtraction underflow");
+            check(amount <= max_amount, "subtraction overflow");
+            return *this;
+        }
+
+        asset& operator+=( const asset& a ) {
+            check(a.symbol == symbol, "attempt to add asset with different symbol");
+            amount += a.amount;
+            check(-max_amount <= amount, "addition underflow");
+            check(amount <= max_amount, "addition overflow");
+            return *this;
+        }
+
+        friend asset operator+( const asset& a, const asset& b ) {
+            asset result = a;
+            result += b;
+            return result;
+        }
+
+        friend asset operator-( const asset& a, const asset& b ) {
+            asset result = a;
+            result -= b;
+            return result;
+        }
+
+        friend bool operator==( const asset& a, const asset& b ) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount == b.amount;
+        }
+
+        friend bool operator!=( const asset& a, const asset& b ) { return !(a == b); }
+
+        friend bool operator<( const asset& a, const asset& b ) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount < b.amount;
+        }
+
+        friend bool operator<=( const asset& a, const asset& b ) { return !(b < a); }
+        friend bool operator>( const asset& a, const asset& b ) { return b < a; }
+        friend bool operator>=( const asset& a, const asset& b ) { return !(a < b); }
+
+        std::string to_string() const {
+            const bool negative = amount < 0;
+            const uint64_t abs_amount = negative ? -static_cast<uint64_t>(amount) : amount;
+            std::string digits = std::to_string(abs_amount);
+            const uint8_t precision = symbol.precision();
+            if (precision > 0) {
+                if (digits.size() <= precision) {
+                    digits.insert(0, precision + 1 - digits.size(), '0');
+                }
+                digits.insert(digits.size() - precision, 1, '.');
+            }
+            return (negative ? "-" : "") + digits + " " + symbol.code().to_string();
+        }
+    };
+
+    struct extended_asset {
+        asset quantity;
+        name contract;
+
+        extended_asset() = default;
+        extended_asset( int64_t v, extended_symbol s ) : quantity(v, s.get_symbol()), contract(s.get_contract()) {}
+        extended_asset( asset a, name c ) : quantity(a), contract(c) {}
+
+        extended_symbol get_extended_symbol() const { return extended_symbol{quantity.symbol, contract}; }
+
+        extended_asset operator-() const { return {-quantity, contract}; }
+
+        extended_asset& operator-=( const extended_asset& a ) {
+            check(a.contract == contract, "type mismatch");
+            quantity -= a.quantity;
+            return *this;
+        }
+
+        extended_asset& operator+=( const extended_asset& a ) {
+            check(a.contract == contract, "type mismatch");
+            quantity += a.quantity;
+            return *this;
+        }
+
+        friend extended_asset operator-( const extended_asset& a, const extended_asset& b ) {
+            check(a.contract == b.contract, "type mismatch");
+            return {a.quantity - b.quantity, a.contract};
+        }
+
+        friend extended_asset operator+( const extended_asset& a, const extended_asset& b ) {
+            check(a.contract == b.contract, "type mismatch");
+            return {a.quantity + b.quantity, a.contract};
+        }
+
+        friend bool operator==( const extended_asset& a, const extended_asset& b ) {
+            return std::tie(a.quantity, a.contract) == std::tie(b.quantity, b.contract);
+        }
+
+        friend bool operator!=( const extended_asset& a, const extended_asset& b ) { return !(a == b); }
+    };
+}
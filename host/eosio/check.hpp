@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+    namespace host {
+        // Thrown by a failed `check`, the host counterpart of `eosio_assert` aborting the transaction
+        struct assertion_failure : std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+    }
+
+    inline void check( bool pred, const char* msg ) {
+        if (!pred) throw host::assertion_failure(msg);
+    }
+
+    inline void check( bool pred, const std::string& msg ) {
+        if (!pred) throw host::assertion_failure(msg);
+    }
+
+    inline void check( bool pred, std::string_view msg ) {
+        if (!pred) throw host::assertion_failure(std::string(msg));
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <eosio/name.hpp>
+#include <eosio/datastream.hpp>
+
+namespace eosio {
+
+    class contract {
+        public:
+            contract( name self, name first_receiver, datastream<const char*> ds )
+                : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+            inline name get_self() const { return _self; }
+            inline name get_code() const { return _first_receiver; }
+            inline name get_first_receiver() const { return _first_receiver; }
+            inline datastream<const char*>& get_datastream() { return _ds; }
+
+        protected:
+            name _self;
+            name _first_receiver;
+            datastream<const char*> _ds;
+    };
+}
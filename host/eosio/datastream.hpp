@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace eosio {
+
+    // Action data is passed as typed arguments on the host, the stream only carries its bounds
+    template<typename T>
+    class datastream {
+        public:
+            datastream( T start, std::size_t s ) : _start(start), _pos(start), _end(start + s) {}
+
+            std::size_t remaining() const { return _end - _pos; }
+
+        private:
+            T _start;
+            T _pos;
+            T _end;
+    };
+}
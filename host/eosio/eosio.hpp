@@ -0,0 +1,20 @@
+#pragma once
+
+// Native stand-in for the CDT headers, so the contract sources build as a host library
+// The intrinsics & the database are emulated by `eosio::host::chain()`, see host.hpp
+
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+#include <eosio/action.hpp>
+#include <eosio/contract.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/multi_index.hpp>
+#include <eosio/print.hpp>
+#include <eosio/time.hpp>
+
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
+
+#define ACTION [[eosio::action]] void
+#define TABLE struct [[eosio::table]]
+#define CONTRACT class [[eosio::contract]]
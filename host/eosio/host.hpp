@@ -0,0 +1,74 @@
+#pragma once
+
+#include <eosio/action.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/time.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace eosio {
+    namespace host {
+
+        // Storage of one (code, scope, table), see `table_store` in multi_index.hpp
+        struct table_base {
+            virtual ~table_base() = default;
+        };
+
+        // In-memory chain the contract runs against on the host: the database & the intrinsics of the current action
+        class chain_state {
+            public:
+                time_point                      now;
+                name                            receiver;
+                std::set<name>                  auths;
+                std::set<name>                  accounts;
+                std::vector<name>               recipients;
+                std::vector<action>             actions;
+                std::string                     console;
+
+                template<typename Store>
+                Store& table( name code, uint64_t scope, name table_name ) {
+                    auto& slot = tables[std::make_tuple(code.value, scope, table_name.value)];
+                    if (!slot) {
+                        slot = std::make_unique<Store>();
+                    }
+                    auto* store = dynamic_cast<Store*>(slot.get());
+                    check(store != nullptr, "table " + table_name.to_string() + " is opened with another row type");
+                    return *store;
+                }
+
+                // Records how to revert a database change made by the current action
+                void journal( std::function<void()> undo ) { undo_log.push_back(std::move(undo)); }
+
+                void begin_action( name self, std::vector<name> authorizers );
+                void rollback();
+                void reset();
+
+            private:
+                std::map<std::tuple<uint64_t, uint64_t, uint64_t>, std::unique_ptr<table_base>> tables;
+                std::vector<std::function<void()>> undo_log;
+        };
+
+        chain_state& chain();
+
+        // Runs `act` of `Contract` as `receiver` with the authority of `authorizers`
+        // A failed `check` reverts every database change of the action & is rethrown
+        template<typename Contract, typename... Params, typename... Args>
+        void push_action( name receiver, name code, std::vector<name> authorizers, void (Contract::*act)(Params...), Args&&... args ) {
+            auto& state = chain();
+            state.begin_action(receiver, std::move(authorizers));
+            try {
+                Contract contract(receiver, code, datastream<const char*>(nullptr, 0));
+                (contract.*act)(std::forward<Args>(args)...);
+            } catch (...) {
+                state.rollback();
+                throw;
+            }
+        }
+    }
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <eosio/host.hpp>
+
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+    template<name::raw IndexName, typename Extractor>
+    struct indexed_by {
+        static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+        typedef Extractor secondary_extractor_type;
+    };
+
+    template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+    struct const_mem_fun {
+        typedef typename std::remove_reference<Type>::type result_type;
+
+        Type operator()( const Class& x ) const { return (x.*PtrToMemberFunction)(); }
+    };
+
+    constexpr name same_payer{};
+
+    namespace host {
+
+        // Rows of one table ordered by primary key, each secondary index ordered by (secondary key, primary key)
+        // Every change is journaled on the chain so a failed action can be reverted
+        template<typename T, typename... Indices>
+        struct table_store : table_base {
+            template<std::size_t I>
+            using extractor = typename std::tuple_element_t<I, std::tuple<Indices...>>::secondary_extractor_type;
+
+            template<typename Index>
+            using index_set = std::set<std::pair<typename Index::secondary_extractor_type::result_type, uint64_t>>;
+
+            std::map<uint64_t, T> rows;
+            std::tuple<index_set<Indices>...> indices;
+
+            const T& emplace( T&& obj ) {
+                const uint64_t pk = obj.primary_key();
+                auto res = rows.emplace(pk, std::move(obj));
+                check(res.second, "could not insert object, most likely a uniqueness constraint was violated");
+                add_keys(res.first->second, std::index_sequence_for<Indices...>{});
+                chain().journal([this, pk]() {
+                    auto itr = rows.find(pk);
+                    remove_keys(itr->second, std::index_sequence_for<Indices...>{});
+                    rows.erase(itr);
+                });
+                return res.first->second;
+            }
+
+            template<typename Lambda>
+            void modify( const T& obj, Lambda&& updater ) {
+                const uint64_t pk = obj.primary_key();
+                T& row = rows.at(pk);
+                T old = row;
+                remove_keys(row, std::index_sequence_for<Indices...>{});
+                updater(row);
+                check(pk == row.primary_key(), "updater cannot change primary key when modifying an object");
+                add_keys(row, std::index_sequence_for<Indices...>{});
+                chain().journal([this, pk, old]() {
+                    T& row = rows.at(pk);
+                    remove_keys(row, std::index_sequence_for<Indices...>{});
+                    row = old;
+                    add_keys(row, std::index_sequence_for<Indices...>{});
+                });
+            }
+
+            void erase( const T& obj ) {
+                const uint64_t pk = obj.primary_key();
+                auto itr = rows.find(pk);
+                remove_keys(itr->second, std::index_sequence_for<Indices...>{});
+                chain().journal([this, pk, old = std::move(itr->second)]() {
+                    auto res = rows.emplace(pk, old);
+                    add_keys(res.first->second, std::index_sequence_for<Indices...>{});
+                });
+                rows.erase(itr);
+            }
+
+            template<std::size_t... I>
+            void add_keys( const T& obj, std::index_sequence<I...> ) {
+                (std::get<I>(indices).emplace(extractor<I>()(obj), obj.primary_key()), ...);
+            }
+
+            template<std::size_t... I>
+            void remove_keys( const T& obj, std::index_sequence<I...> ) {
+                (std::get<I>(indices).erase(std::make_pair(extractor<I>()(obj), obj.primary_key())), ...);
+            }
+        };
+    }
+
+    // Host `multi_index` with the interface of the CDT one, rows live in `host::chain()` keyed by (code, scope, table)
+    template<name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+        private:
+            typedef host::table_store<T, Indices...> store_type;
+
+            template<name::raw IndexName, std::size_t I = 0>
+            static constexpr std::size_t index_position() {
+                static_assert(I < sizeof...(Indices), "name not found in indices");
+                if constexpr (std::tuple_element_t<I, std::tuple<Indices...>>::index_name == static_cast<uint64_t>(IndexName)) {
+                    return I;
+                } else {
+                    return index_position<IndexName, I + 1>();
+                }
+            }
+
+            name _code;
+            uint64_t _scope;
+            store_type* _store;
+
+        public:
+            class const_iterator {
+                public:
+                    using iterator_category = std::bidirectional_iterator_tag;
+                    using value_type = T;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const T*;
+                    using reference = const T&;
+
+                    const_iterator() = default;
+                    explicit const_iterator( typename std::map<uint64_t, T>::const_iterator itr ) : _itr(itr) {}
+
+                    const T& operator*() const { return _itr->second; }
+                    const T* operator->() const { return &_itr->second; }
+
+                    const_iterator& operator++() { ++_itr; return *this; }
+                    const_iterator operator++( int ) { const_iterator result = *this; ++_itr; return result; }
+                    const_iterator& operator--() { --_itr; return *this; }
+                    const_iterator operator--( int ) { const_iterator result = *this; --_itr; return result; }
+
+                    friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._itr == b._itr; }
+                    friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._itr != b._itr; }
+
+                private:
+                    typename std::map<uint64_t, T>::const_iterator _itr;
+            };
+
+            // Secondary index, iterators refer to the row so they stay valid when the row is modified
+            template<name::raw IndexName, typename Extractor, std::size_t N>
+            class index {
+                public:
+                    typedef typename Extractor::result_type secondary_key_type;
+
+                    class const_iterator {
+                        public:
+                            using iterator_category = std::bidirectional_iterator_tag;
+                            using value_type = T;
+                            using difference_type = std::ptrdiff_t;
+                            using pointer = const T*;
+                            using reference = const T&;
+
+                            const_iterator() = default;
+                            const_iterator( store_type* store, const T* item ) : _store(store), _item(item) {}
+
+                            const T& operator*() const { return *_item; }
+                            const T* operator->() const { return _item; }
+
+                            const_iterator& operator++() {
+                                check(_item != nullptr, "cannot increment end iterator");
+                                auto& keys = std::get<N>(_store->indices);
+                                auto next = keys.upper_bound(std::make_pair(Extractor()(*_item), _item->primary_key()));
+                                _item = next == keys.end() ? nullptr : &_store->rows.at(next->second);
+                                return *this;
+                            }
+
+                            const_iterator operator++( int ) { const_iterator result = *this; ++(*this); return result; }
+
+                            const_iterator& operator--() {
+                                auto& keys = std::get<N>(_store->indices);
+                                auto prev = _item == nullptr ? keys.end() : keys.lower_bound(std::make_pair(Extractor()(*_item), _item->primary_key()));
+                                check(prev != keys.begin(), "cannot decrement iterator at beginning of index");
+                                _item = &_store->rows.at(std::prev(prev)->second);
+                                return *this;
+                            }
+
+                            const_iterator operator--( int ) { const_iterator result = *this; --(*this); return result; }
+
+                            friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._item == b._item; }
+                            friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._item != b._item; }
+
+                        private:
+                            store_type* _store = nullptr;
+                            const T* _item = nullptr;
+                    };
+
+                    explicit index( store_type* store ) : _store(store) {}
+
+                    const_iterator begin() const { return at(keys().begin()); }
+                    const_iterator end() const { return const_iterator(_store, nullptr); }
+
+                    const_iterator lower_bound( secondary_key_type secondary ) const {
+                        return at(keys().lower_bound(std::make_pair(secondary, std::numeric_limits<uint64_t>::min())));
+                    }
+
+                    const_iterator upper_bound( secondary_key_type secondary ) const {
+                        return at(keys().upper_bound(std::make_pair(secondary, std::numeric_limits<uint64_t>::max())));
+                    }
+
+                    const_iterator find( secondary_key_type secondary ) const {
+                        auto itr = keys().lower_bound(std::make_pair(secondary, std::numeric_limits<uint64_t>::min()));
+                        return itr != keys().end() && itr->first == secondary ? at(itr) : end();
+                    }
+
+                    const T& get( secondary_key_type secondary, const char* error_msg = "unable to find secondary key" ) const {
+                        auto result = find(secondary);
+                        check(result != end(), error_msg);
+                        return *result;
+                    }
+
+                    const_iterator iterator_to( const T& obj ) const { return const_iterator(_store, &obj); }
+
+                    template<typename Lambda>
+                    void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                        check(itr != end(), "cannot pass end iterator to modify");
+                        _store->modify(*itr, std::forward<Lambda>(updater));
+                    }
+
+                    const_iterator erase( const_iterator itr ) {
+                        check(itr != end(), "cannot pass end iterator to erase");
+                        const_iterator next = itr;
+                        ++next;
+                        _store->erase(*itr);
+                        return next;
+                    }
+
+                    static auto extract_secondary_key( const T& obj ) { return Extractor()(obj); }
+
+                private:
+                    store_type* _store;
+
+                    const typename store_type::template index_set<std::tuple_element_t<N, std::tuple<Indices...>>>& keys() const {
+                        return std::get<N>(_store->indices);
+                    }
+
+                    template<typename KeyIterator>
+                    const_iterator at( KeyIterator itr ) const {
+                        return itr == keys().end() ? end() : const_iterator(_store, &_store->rows.at(itr->second));
+                    }
+            };
+
+            multi_index( name code, uint64_t scope )
+                : _code(code), _scope(scope), _store(&host::chain().template table<store_type>(code, scope, name(TableName))) {}
+
+            name get_code() const { return _code; }
+            uint64_t get_scope() const { return _scope; }
+
+            const_iterator begin() const { return const_iterator(_store->rows.cbegin()); }
+            const_iterator end() const { return const_iterator(_store->rows.cend()); }
+
+            const_iterator lower_bound( uint64_t primary ) const { return const_iterator(_store->rows.lower_bound(primary)); }
+            const_iterator upper_bound( uint64_t primary ) const { return const_iterator(_store->rows.upper_bound(primary)); }
+            const_iterator find( uint64_t primary ) const { return const_iterator(_store->rows.find(primary)); }
+
+            const T& get( uint64_t primary, const char* error_msg = "unable to find key" ) const {
+                auto result = find(primary);
+                check(result != end(), error_msg);
+                return *result;
+            }
+
+            const_iterator iterator_to( const T& obj ) const { return find(obj.primary_key()); }
+
+            uint64_t available_primary_key() const {
+                return _store->rows.empty() ? 0 : _store->rows.rbegin()->first + 1;
+            }
+
+            template<name::raw IndexName>
+            auto get_index() const {
+                constexpr std::size_t position = index_position<IndexName>();
+                typedef typename std::tuple_element_t<position, std::tuple<Indices...>>::secondary_extractor_type extractor_type;
+                return index<IndexName, extractor_type, position>(_store);
+            }
+
+            template<typename Lambda>
+            const_iterator emplace( name payer, Lambda&& constructor ) {
+                T obj;
+                constructor(obj);
+                return find(_store->emplace(std::move(obj)).primary_key());
+            }
+
+            template<typename Lambda>
+            void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                check(itr != end(), "cannot pass end iterator to modify");
+                _store->modify(*itr, std::forward<Lambda>(updater));
+            }
+
+            template<typename Lambda>
+            void modify( const T& obj, name payer, Lambda&& updater ) {
+                _store->modify(obj, std::forward<Lambda>(updater));
+            }
+
+            const_iterator erase( const_iterator itr ) {
+                check(itr != end(), "cannot pass end iterator to erase");
+                const_iterator next = itr;
+                ++next;
+                _store->erase(*itr);
+                return next;
+            }
+
+            void erase( const T& obj ) {
+                _store->erase(obj);
+            }
+    };
+}
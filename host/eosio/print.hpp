@@ -0,0 +1,26 @@
+#pragma once
+
+#include <eosio/host.hpp>
+
+#include <sstream>
+
+namespace eosio {
+
+    namespace host {
+        inline void print_value( std::ostream& os, const name& n ) { os << n.to_string(); }
+
+        template<typename T>
+        auto print_value( std::ostream& os, const T& value ) -> decltype(os << value, void()) { os << value; }
+
+        template<typename T>
+        auto print_value( std::ostream& os, const T& value ) -> decltype(value.to_string(), void()) { os << value.to_string(); }
+    }
+
+    // Appended to the console of the current action, as `--contracts-console` shows it
+    template<typename... Args>
+    void print( Args&&... args ) {
+        std::ostringstream os;
+        (host::print_value(os, args), ...);
+        host::chain().console += os.str();
+    }
+}
@@ -0,0 +1,75 @@
+#include <eosio/eosio.hpp>
+
+#include <algorithm>
+
+namespace eosio {
+    namespace host {
+
+        chain_state& chain() {
+            static chain_state state;
+            return state;
+        }
+
+        void chain_state::begin_action( name self, std::vector<name> authorizers ) {
+            receiver = self;
+            auths = std::set<name>(authorizers.begin(), authorizers.end());
+            recipients.clear();
+            actions.clear();
+            console.clear();
+            undo_log.clear();
+        }
+
+        void chain_state::rollback() {
+            // Revert in reverse order, each entry restores the state before its change
+            for (auto itr = undo_log.rbegin(); itr != undo_log.rend(); ++itr) {
+                (*itr)();
+            }
+            undo_log.clear();
+            recipients.clear();
+            actions.clear();
+        }
+
+        void chain_state::reset() {
+            tables.clear();
+            undo_log.clear();
+            auths.clear();
+            accounts.clear();
+            recipients.clear();
+            actions.clear();
+            console.clear();
+            now = time_point();
+            receiver = name();
+        }
+    }
+
+    time_point current_time_point() {
+        return host::chain().now;
+    }
+
+    void action::send() const {
+        host::chain().actions.push_back(*this);
+    }
+
+    void require_auth( name n ) {
+        check(has_auth(n), "missing authority of " + n.to_string());
+    }
+
+    bool has_auth( name n ) {
+        return host::chain().auths.count(n) != 0;
+    }
+
+    void require_recipient( name notify_account ) {
+        auto& recipients = host::chain().recipients;
+        if (std::find(recipients.begin(), recipients.end(), notify_account) == recipients.end()) {
+            recipients.push_back(notify_account);
+        }
+    }
+
+    bool is_account( name n ) {
+        return host::chain().accounts.count(n) != 0;
+    }
+
+    name current_receiver() {
+        return host::chain().receiver;
+    }
+}
@@ -2,13 +2,16 @@
 #include <eosio/asset.hpp>
 #include <eosio/time.hpp>
 #include <eosio/transaction.hpp>
+#include <eosio/singleton.hpp>
 
 #include <string>
+#include <algorithm>
 #include <optional>
 
 using eosio::const_mem_fun;
 using eosio::indexed_by;
 using eosio::multi_index;
+using eosio::singleton;
 using eosio::extended_asset;
 using eosio::check;
 using eosio::datastream;
@@ -28,13 +31,27 @@ class [[eosio::contract("escrow")]] escrow : public eosio::contract {
 
         escrow(name s, name code, datastream<const char *> ds)
                 : contract(s, code, ds),
-                  escrows(_self, _self.value) {
+                  directory(_self, _self.value),
+                  memos(_self, _self.value),
+                  schedules(_self, _self.value),
+                  vestings(_self, _self.value),
+                  fees(_self, _self.value),
+                  fee_shares(_self, _self.value) {
             sending_code = name{code};
         }
 
         ~escrow();
 
-        [[eosio::on_notify("eosio.token::transfer")]]
+        // Parameters of one escrow created by `initmany`
+        struct escrow_spec {
+            name            receiver;
+            name            approver;
+            name            escrow_name;
+            time_point_sec  expires_at;
+            string          memo;
+        };
+
+        [[eosio::on_notify("*::transfer")]]
         void transfer(name from, name to, asset quantity, string memo);
 
         [[eosio::action]]
@@ -47,18 +64,71 @@ class [[eosio::contract("escrow")]] escrow : public eosio::contract {
             const string         memo
         );
 
+        [[eosio::action]]
+        void initmany(const name sender, vector<escrow_spec> specs);
+
+        // Amount & unlock time of one tranche of a milestone escrow
+        struct tranche_spec {
+            int64_t         amount;
+            time_point_sec  unlock_at;
+        };
+
+        [[eosio::action]]
+        void initsched(
+            const name                  sender,
+            const name                  receiver,
+            const name                  approver,
+            const name                  escrow_name,
+            const time_point_sec        expires_at,
+            const string                memo,
+            const vector<tranche_spec>  tranches
+        );
+
+        [[eosio::action]]
+        void initvest(
+            const name           sender,
+            const name           receiver,
+            const name           approver,
+            const name           escrow_name,
+            const time_point_sec start_at,
+            const time_point_sec end_at,
+            const time_point_sec expires_at,
+            const string         memo
+        );
+
         [[eosio::action]]
         void approve(const name escrow_name, const name approver);
 
+        [[eosio::action]]
+        void approvemany(const name approver, const vector<name> escrow_names);
+
+        [[eosio::action]]
+        void approvelog(const name approver, const vector<name> escrow_names, const vector<uint8_t> results);
+
         [[eosio::action]]
         void unapprove(const name escrow_name, const name unapprover);
 
         [[eosio::action]]
         void claim(const name escrow_name);
 
+        [[eosio::action]]
+        void approvetr(const name escrow_name, const name approver, const uint8_t index);
+
+        [[eosio::action]]
+        void unapprovetr(const name escrow_name, const name unapprover, const uint8_t index);
+
+        [[eosio::action]]
+        void claimtr(const name escrow_name, const uint8_t index);
+
+        [[eosio::action]]
+        void claimall(const name receiver, const uint32_t max);
+
         [[eosio::action]]
         void refund(const name escrow_name);
 
+        [[eosio::action]]
+        void sweep(const uint32_t max_rows);
+
         [[eosio::action]]
         void cancel(const name escrow_name);
 
@@ -72,13 +142,100 @@ class [[eosio::contract("escrow")]] escrow : public eosio::contract {
         void lock(const name escrow_name, const bool locked);
 
         [[eosio::action]]
-        void clean();
+        void setconfig(
+            const vector<name> senders,
+            const vector<name> approvers,
+            const name         token_contract,
+            const symbol       token_symbol,
+            const uint32_t     max_expiry
+        );
 
-    private:
-        // 6 months in seconds (Computatio: 6 months * average days per month * 24 hours * 60 minutes * 60 seconds)
+        [[eosio::action]]
+        void addtoken(const name contract, const symbol sym);
+
+        [[eosio::action]]
+        void rmtoken(const name contract, const symbol sym);
+
+        [[eosio::action]]
+        void setfee(const name approver, const uint16_t fee_bps);
+
+        [[eosio::action]]
+        void setshares(const name account, const uint64_t shares);
+
+        [[eosio::action]]
+        void claimfees(const name account);
+
+        [[eosio::action]]
+        void clean(const uint32_t max_rows);
+
+        [[eosio::action]]
+        void migrate(const uint32_t max_rows);
+
+        // Tables & their constants are public, other contracts & tools read them with the same types
+
+        // Default maximum expiry, 6 months in seconds (Computatio: 6 months * average days per month * 24 hours * 60 minutes * 60 seconds)
         constexpr static uint32_t SIX_MONTHS_IN_SECONDS = (uint32_t) (6 * (365.25 / 12) * 24 * 60 * 60);
 
+        // Fees are expressed in basis points of the escrow amount
+        constexpr static uint16_t BPS_DENOMINATOR = 10000;
+        constexpr static uint16_t DEFAULT_EOSIO_FEE_BPS = 1000;
+
+        // Scale of `fee_pool_row::acc_per_share`
+        constexpr static uint64_t FEE_PRECISION = 1000000000000;
+
+        // Approval slots of `escrow_row::approvals`
+        constexpr static uint8_t APPROVED_BY_SENDER = 1 << 0;
+        constexpr static uint8_t APPROVED_BY_APPROVER = 1 << 1;
+
+        // Maximum memo size accepted by `eosio.token::transfer`
+        constexpr static uint32_t MAX_MEMO_SIZE = 256;
+
+        // Result codes of approving an escrow, reported per escrow by `approvelog`
+        enum approve_result : uint8_t {
+            APPROVED = 0,
+            NOT_FOUND = 1,
+            NOT_FUNDED = 2,
+            NOT_ALLOWED = 3,
+            ALREADY_APPROVED = 4,
+            HAS_TRANCHES = 5
+        };
+
+        // Kinds of `escrow_row`, a milestone escrow keeps its tranches in `schedules`, a vesting escrow its schedule in `vestings`
+        constexpr static uint8_t ESCROW_SINGLE = 0;
+        constexpr static uint8_t ESCROW_MILESTONES = 1;
+        constexpr static uint8_t ESCROW_VESTING = 2;
+
+        constexpr static uint32_t MAX_TRANCHES = 64;
+
+        // Escrow, scoped by `sender` (see `escrowdir` to resolve the scope of an `escrow_name`)
+        // Fixed-size row (55 bytes packed), `find` decodes it without any allocation
+        // Keep variable-length data out of this row, in a table keyed by `escrow_name` (see `escrowmemo`)
+        // `receiver` & `expires_at` are only stored in `escrowdir`, which every action reads to find the scope
+        // `approvals` of a milestone escrow are the approvals of its unclaimed tranches, see `schedule_row::pending_approvals`
         struct [[eosio::table]] escrow_row {
+            name            escrow_name;
+            name            sender;
+            name            approver;
+            uint8_t         approvals = 0;
+            extended_asset  ext_asset;
+            time_point_sec  created_at;
+            bool            locked = false;
+            uint8_t         kind = ESCROW_SINGLE;
+
+            auto            primary_key() const { return escrow_name.value; }
+            uint64_t        by_funded() const { return ext_asset.quantity.amount > 0 ? 1 : 0; }
+            uint8_t         approval_slot(const name account) const { return account == sender ? APPROVED_BY_SENDER : account == approver ? APPROVED_BY_APPROVER : 0; }
+            bool            is_claimable() const { return ext_asset.quantity.amount > 0 && !locked && approvals != 0 && kind == ESCROW_SINGLE; }
+        };
+
+        // `byfunded` lets `transfer` find the un-filled escrow of a sender in a single lookup
+        typedef multi_index<"escrows"_n, escrow_row,
+            indexed_by<"byfunded"_n, const_mem_fun<escrow_row, uint64_t, &escrow_row::by_funded> >
+        > escrows_table;
+
+        // Row of `escrows` in the scope of escrow.bos, written by the contract before escrows were scoped by sender
+        // Not an ABI table, only read by `migrate` which moves each row to the scope of its sender
+        struct legacy_escrow_row {
             name            escrow_name;
             name            sender;
             name            receiver;
@@ -92,13 +249,210 @@ class [[eosio::contract("escrow")]] escrow : public eosio::contract {
 
             auto            primary_key() const { return escrow_name.value; }
             uint64_t        by_sender() const { return sender.value; }
-            bool            is_expired() const { return time_point_sec(current_time_point()) > expires_at; }
         };
 
-        typedef multi_index<"escrows"_n, escrow_row,
-            indexed_by<"bysender"_n, const_mem_fun<escrow_row, uint64_t, &escrow_row::by_sender> >
-        > escrows_table;
+        typedef multi_index<"escrows"_n, legacy_escrow_row,
+            indexed_by<"bysender"_n, const_mem_fun<legacy_escrow_row, uint64_t, &legacy_escrow_row::by_sender> >
+        > legacy_escrows_table;
+
+        // Directory of all escrows, maps `escrow_name` to the `sender` scope of its row
+        // Also orders escrows of all senders by expiry & receiver for `sweep` & `claimall`
+        // Costs 392 billed bytes per escrow (row & 2 index entries), 128 more than the same indexes on a single-scope `escrows`
+        struct [[eosio::table]] directory_row {
+            name            escrow_name;
+            name            sender;
+            name            receiver;
+            time_point_sec  expires_at;
 
-        escrows_table escrows;
+            auto            primary_key() const { return escrow_name.value; }
+            uint64_t        by_expiry() const { return expires_at.utc_seconds; }
+            uint64_t        by_receiver() const { return receiver.value; }
+        };
+
+        typedef multi_index<"escrowdir"_n, directory_row,
+            indexed_by<"byexpiry"_n, const_mem_fun<directory_row, uint64_t, &directory_row::by_expiry> >,
+            indexed_by<"byreceiver"_n, const_mem_fun<directory_row, uint64_t, &directory_row::by_receiver> >
+        > directory_table;
+
+        // Memo of an escrow, only loaded when the escrow is paid out
+        struct [[eosio::table]] memo_row {
+            name            escrow_name;
+            string          memo;
+
+            auto            primary_key() const { return escrow_name.value; }
+        };
+
+        typedef multi_index<"escrowmemo"_n, memo_row> memos_table;
+
+        // Tranche of a milestone escrow, approved & claimed on its own
+        struct tranche {
+            int64_t         amount;
+            time_point_sec  unlock_at;
+            uint8_t         approvals = 0;
+            bool            claimed = false;
+        };
+
+        // Tranches of a milestone escrow, only loaded by the tranche actions & deposit
+        struct [[eosio::table]] schedule_row {
+            name            escrow_name;
+            vector<tranche> tranches;
+
+            auto            primary_key() const { return escrow_name.value; }
+            int64_t         total() const {
+                int64_t sum = 0;
+                for (const auto& tr : tranches) {
+                    sum += tr.amount;
+                }
+                return sum;
+            }
+            uint8_t         pending_approvals() const {
+                uint8_t approvals = 0;
+                for (const auto& tr : tranches) {
+                    approvals |= tr.claimed ? 0 : tr.approvals;
+                }
+                return approvals;
+            }
+        };
+
+        typedef multi_index<"schedules"_n, schedule_row> schedules_table;
+
+        // Linear vesting schedule of a vesting escrow, `claimed` is the amount paid out so far
+        struct [[eosio::table]] vesting_row {
+            name            escrow_name;
+            time_point_sec  start_at;
+            time_point_sec  end_at;
+            int64_t         claimed = 0;
+
+            auto            primary_key() const { return escrow_name.value; }
+            int64_t         vested(const int64_t total, const time_point_sec now) const {
+                if (now <= start_at) return 0;
+                if (now >= end_at) return total;
+                return static_cast<int64_t>( static_cast<int128_t>(total) * (now.sec_since_epoch() - start_at.sec_since_epoch()) / (end_at.sec_since_epoch() - start_at.sec_since_epoch()) );
+            }
+        };
+
+        typedef multi_index<"vestings"_n, vesting_row> vestings_table;
+
+        // Escrow policy, see `get_config` for the defaults
+        struct [[eosio::table("config")]] config_row {
+            vector<name>    senders;
+            vector<name>    approvers;
+            name            token_contract;
+            symbol          token_symbol;
+            uint32_t        max_expiry;
+        };
+
+        typedef singleton<"config"_n, config_row> config_singleton;
+
+        // Token accepted in addition to the configured token, scoped by token contract
+        struct [[eosio::table]] token_row {
+            symbol          sym;
+
+            auto            primary_key() const { return sym.code().raw(); }
+        };
+
+        typedef multi_index<"tokens"_n, token_row> tokens_table;
+
+        // Fee withheld when `approver` approves an escrow
+        struct [[eosio::table]] fee_row {
+            name            approver;
+            uint16_t        fee_bps;
+
+            auto            primary_key() const { return approver.value; }
+        };
+
+        typedef multi_index<"fees"_n, fee_row> fees_table;
+
+        // Pool of the fees withheld on approval, shared by weight between the BPs and auditors
+        struct [[eosio::table("feepool")]] fee_pool_row {
+            name            token_contract;
+            symbol          token_symbol;
+            uint64_t        total_shares = 0;
+            uint128_t       acc_per_share = 0;
+            int64_t         undistributed = 0;
+        };
+
+        typedef singleton<"feepool"_n, fee_pool_row> fee_pool_singleton;
+
+        // Share weight of a fee pool beneficiary, `reward_debt` is the part of `acc_per_share` already settled
+        struct [[eosio::table]] fee_share_row {
+            name            account;
+            uint64_t        shares = 0;
+            uint128_t       reward_debt = 0;
+            int64_t         pending = 0;
+
+            auto            primary_key() const { return account.value; }
+        };
+
+        typedef multi_index<"feeshares"_n, fee_share_row> fee_shares_table;
+
+        // Counters of the `escrows` table, kept up to date by every action changing an escrow
+        // `approved` counts a milestone escrow while one of its unclaimed tranches is approved
+        struct [[eosio::table("stats")]] stats_row {
+            uint64_t                open = 0;
+            uint64_t                funded = 0;
+            uint64_t                approved = 0;
+            uint64_t                locked = 0;
+            vector<extended_asset>  held;
+        };
+
+        typedef singleton<"stats"_n, stats_row> stats_singleton;
+
+    private:
+        // Payout of a batch operation, one token transfer per (token contract, symbol, recipient)
+        struct payout {
+            name            to;
+            extended_asset  ext_asset;
+            vector<name>    escrow_names;
+            string          memo;
+        };
+
+        // Cursor of a `clean` spanning several transactions
+        struct [[eosio::table("cleanstate")]] clean_state_row {
+            uint64_t        cursor = 0;
+            uint64_t        removed = 0;
+        };
+
+        typedef singleton<"cleanstate"_n, clean_state_row> clean_singleton;
+
+        directory_table directory;
+        memos_table memos;
+        schedules_table schedules;
+        vestings_table vestings;
+        fees_table fees;
+        fee_shares_table fee_shares;
+        std::optional<config_row> _config;
+        std::optional<fee_pool_row> _fee_pool;
+        std::optional<stats_row> _stats;
+        vector<name> known_accounts;
         name sending_code;
+
+        static bool parse_escrow_name( const string& memo, name& escrow_name );
+        const config_row& get_config();
+        static bool is_allowed( const vector<name>& whitelist, const name account );
+        bool is_token_allowed( const name contract, const symbol sym );
+        uint16_t get_fee_bps( const name approver );
+        fee_pool_row& get_fee_pool();
+        bool is_fee_token( const extended_asset& ext_asset );
+        void credit_fee( const extended_asset& fee );
+        int64_t settle_fees( const fee_share_row& share );
+        static int64_t deduct_fee( const int64_t amount, const uint16_t fee_bps );
+        void check_init( const name sender );
+        void check_account( const name account, const char* error );
+        void init_escrow( const name sender, const escrow_spec& spec, const time_point_sec time_now, const uint8_t kind = ESCROW_SINGLE );
+        void claim_vested( escrows_table& escrows, const escrows_table::const_iterator& esc_itr );
+        void check_deposit( const escrow_row& row, const asset& quantity );
+        uint8_t approve_escrow( const directory_table::const_iterator& dir_itr, const name approver, const uint16_t fee_bps );
+        escrows_table get_shard( const name escrow_name );
+        void erase_escrow( escrows_table& escrows, const escrows_table::const_iterator& esc_itr );
+        void erase_row( escrows_table& escrows, const escrows_table::const_iterator& esc_itr );
+        stats_row& get_stats();
+        void stats_add( const escrow_row& row );
+        void stats_remove( const escrow_row& row );
+        void update_stats( const escrow_row& row, const int8_t delta );
+        string take_memo( const name escrow_name );
+        template<typename Iterator>
+        void add_payout( vector<payout>& payouts, const name to, const Iterator& esc_itr, string memo );
+        void send_payouts( const vector<payout>& payouts );
+        void send_transfer( const name to, const extended_asset& ext_asset, const string& memo );
 };
@@ -1,8 +1,21 @@
 #include "escrow.hpp"
 
-escrow::~escrow() {}
+escrow::~escrow()
+{
+    // Fee pool is modified in memory during the action and written back once
+    if (_fee_pool) {
+        fee_pool_singleton fee_pool_table(_self, _self.value);
+        fee_pool_table.set(*_fee_pool, _self);
+    }
+
+    // Stats are updated in memory by every escrow change and written back once
+    if (_stats) {
+        stats_singleton stats_table(_self, _self.value);
+        stats_table.set(*_stats, _self);
+    }
+}
 
-[[eosio::on_notify("eosio.token::transfer")]]
+[[eosio::on_notify("*::transfer")]]
 void escrow::transfer( const name     from,
                        const name     to,
                        const asset    quantity,
@@ -15,24 +28,46 @@ void escrow::transfer( const name     from,
 
     require_auth( from );
 
-    auto by_sender = escrows.get_index<"bysender"_n>();
+    // Any contract can notify a transfer, only accept whitelisted tokens
+    check(is_token_allowed(sending_code, quantity.symbol), "This token is not accepted by the escrow");
 
-    uint8_t found = 0;
+    // Memo-addressed funding, memo carries the `escrow_name` of the escrow to deposit to
+    // A memo naming no escrow of `from` (e.g. "payment") falls back to the only un-filled escrow of `from`
+    name escrow_name;
+    if ( parse_escrow_name( memo, escrow_name ) ) {
+        auto dir_itr = directory.find(escrow_name.value);
 
-    for (auto esc_itr = by_sender.lower_bound(from.value), end_itr = by_sender.upper_bound(from.value); esc_itr != end_itr; ++esc_itr) {
-        if (esc_itr->ext_asset.quantity.amount == 0){
+        if (dir_itr != directory.end() && dir_itr->sender == from) {
+            escrows_table escrows(_self, from.value);
+            auto esc_itr = escrows.find(escrow_name.value);
+            check(esc_itr->ext_asset.quantity.amount == 0, "This escrow has already been filled");
+            check_deposit(*esc_itr, quantity);
 
-            by_sender.modify(esc_itr, from, [&](auto & row) {
+            stats_remove(*esc_itr);
+            escrows.modify(esc_itr, from, [&](auto & row) {
                 row.ext_asset = extended_asset{quantity, sending_code};
             });
-
-            found = 1;
-
-            break;
+            stats_add(*esc_itr);
+            return;
         }
     }
 
-    check(found, "Could not find existing escrow to deposit to, transfer cancelled");
+    // Otherwise deposit to the only un-filled escrow of `from`, look it up directly in the scope of `from`
+    escrows_table escrows(_self, from.value);
+    auto by_funded = escrows.get_index<"byfunded"_n>();
+    auto esc_itr = by_funded.find(0);
+
+    check(esc_itr != by_funded.end(), "Could not find existing escrow to deposit to, transfer cancelled");
+
+    auto next_itr = std::next(esc_itr);
+    check(next_itr == by_funded.end() || next_itr->by_funded() != 0, "You have several empty escrows, set the escrow name as the transfer memo");
+    check_deposit(*esc_itr, quantity);
+
+    stats_remove(*esc_itr);
+    by_funded.modify(esc_itr, from, [&](auto & row) {
+        row.ext_asset = extended_asset{quantity, sending_code};
+    });
+    stats_add(*esc_itr);
 }
 
 ACTION escrow::init( const name           sender,
@@ -42,55 +77,84 @@ ACTION escrow::init( const name           sender,
                      const time_point_sec expires_at,
                      const string         memo)
 {
-    // Validate user input
-    check( sender != receiver, "cannot escrow to self" );
-    check( receiver != approver, "receiver cannot be approver" );
-    require_auth( sender );
-    check( is_account( receiver ), "receiver account does not exist");
-    check( is_account( approver ), "approver account does not exist");
-    check( escrow_name.length() > 2, "escrow name should be at least 3 characters long.");
+    check_init( sender );
 
-    // Validate expire time_point_sec
-    check(expires_at > current_time_point(), "expires_at must be a value in the future.");
-    time_point_sec max_expires_at = current_time_point() + time_point_sec(SIX_MONTHS_IN_SECONDS);
-    check(expires_at <= max_expires_at, "expires_at must be within 6 months from now.");
+    init_escrow(sender, escrow_spec{receiver, approver, escrow_name, expires_at, memo}, time_point_sec(current_time_point()));
+}
 
-    // Enforce `sender` as BOS Executive & `approver` as EOSIO
-    // Asserts should be removed once escrow.bos is ready for public use
-    check(sender == name("bet.bos"), "sender must be bet.bos");
-    check(approver == name("eosio"), "approver must be eosio");
+/**
+ * Creates a batch of escrows for the same `sender`, shared checks are done once
+ */
+ACTION escrow::initmany( const name sender, vector<escrow_spec> specs )
+{
+    check_init( sender );
+    check(!specs.empty(), "specs cannot be empty");
 
-    // Notify the following accounts
-    require_recipient( sender );
-    require_recipient( receiver );
-    require_recipient( approver );
+    // Emplace rows in primary key order
+    std::sort(specs.begin(), specs.end(), [](const escrow_spec& a, const escrow_spec& b) {
+        return a.escrow_name < b.escrow_name;
+    });
 
-    // Set Escrow deposit as `eosio.token` BOS (Extended Asset)
-    extended_asset zero_asset{{0, symbol{"BOS", 4}}, "eosio.token"_n};
+    const time_point_sec time_now = time_point_sec(current_time_point());
+    for (const auto& spec : specs) {
+        init_escrow(sender, spec, time_now);
+    }
+}
 
+/**
+ * Creates a milestone escrow, a single deposit funds all `tranches`
+ */
+ACTION escrow::initsched( const name                  sender,
+                          const name                  receiver,
+                          const name                  approver,
+                          const name                  escrow_name,
+                          const time_point_sec        expires_at,
+                          const string                memo,
+                          const vector<tranche_spec>  tranches )
+{
+    check_init( sender );
+    check(!tranches.empty(), "tranches cannot be empty");
+    check(tranches.size() <= MAX_TRANCHES, "too many tranches");
 
-    // Sender can only have one un-filled escrow
-    // Sender must either transfer BOS to `escrow.bos` or `cancel` the existing escrow
-    auto by_sender = escrows.get_index<"bysender"_n>();
-    for (auto esc_itr = by_sender.lower_bound(sender.value), end_itr = by_sender.upper_bound(sender.value); esc_itr != end_itr; ++esc_itr) {
-        check(esc_itr->ext_asset.quantity.amount != 0, "You already have an empty escrow.  Either transfer BOS to escrow.bos or cancel the escrow");
-    }
+    init_escrow(sender, escrow_spec{receiver, approver, escrow_name, expires_at, memo}, time_point_sec(current_time_point()), ESCROW_MILESTONES);
 
-    // Escrow name must be unique
-    auto esc_itr = escrows.find(escrow_name.value);
-    check(esc_itr == escrows.end(), "escrow with same name already exists.");
+    // Tranches must unlock before the escrow can be refunded, at `expires_at` the claim of the receiver would race the refund
+    int64_t total = 0;
+    schedules.emplace(sender, [&](auto & row) {
+        row.escrow_name = escrow_name;
+        row.tranches.reserve(tranches.size());
+        for (const auto& spec : tranches) {
+            check(spec.amount > 0, "tranche amount must be positive");
+            check(spec.amount <= asset::max_amount - total, "sum of the tranches is out of range");
+            check(spec.unlock_at < expires_at, "tranche must unlock before expires_at");
+            total += spec.amount;
+            row.tranches.push_back(tranche{spec.amount, spec.unlock_at});
+        }
+    });
+}
 
-    // Update `escrows` table
-    escrows.emplace(sender, [&](auto & row) {
+/**
+ * Creates a vesting escrow, funds are released linearly from `start_at` to `end_at`
+ */
+ACTION escrow::initvest( const name           sender,
+                         const name           receiver,
+                         const name           approver,
+                         const name           escrow_name,
+                         const time_point_sec start_at,
+                         const time_point_sec end_at,
+                         const time_point_sec expires_at,
+                         const string         memo )
+{
+    check_init( sender );
+    check(start_at < end_at, "start_at must be before end_at");
+    check(end_at <= expires_at, "end_at must be before expires_at");
+
+    init_escrow(sender, escrow_spec{receiver, approver, escrow_name, expires_at, memo}, time_point_sec(current_time_point()), ESCROW_VESTING);
+
+    vestings.emplace(sender, [&](auto & row) {
         row.escrow_name = escrow_name;
-        row.sender = sender;
-        row.receiver = receiver;
-        row.approver = approver;
-        row.ext_asset = zero_asset;
-        row.expires_at = expires_at;
-        row.created_at = current_time_point();
-        row.memo = memo;
-        row.locked = false;
+        row.start_at = start_at;
+        row.end_at = end_at;
     });
 }
 
@@ -99,28 +163,63 @@ ACTION escrow::approve( const name escrow_name, const name approver )
     require_auth( approver );
 
     // Check if `escrow_name` already exists
-    auto esc_itr = escrows.find(escrow_name.value);
-    check(esc_itr != escrows.end(), "Could not find escrow with that name");
+    const uint8_t result = approve_escrow(directory.find(escrow_name.value), approver, get_fee_bps(approver));
 
-    // Cannot approve escrow with 0 BOS deposits
-    check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
+    check(result != NOT_FOUND, "Could not find escrow with that name");
+    check(result != NOT_FUNDED, "This has not been initialized with a transfer");
+    check(result != NOT_ALLOWED, "You are not allowed to approve this escrow.");
+    check(result != ALREADY_APPROVED, "You have already approved this escrow");
+    check(result != HAS_TRANCHES, "Approve the tranches of this escrow with approvetr");
+}
 
-    // Only `sender` or `approver` can approve escrow
-    check(esc_itr->sender == approver || esc_itr->approver == approver, "You are not allowed to approve this escrow.");
+/**
+ * Approves a list of escrows with a single authorization, results are reported with `approvelog`
+ */
+ACTION escrow::approvemany( const name approver, const vector<name> escrow_names )
+{
+    require_auth( approver );
 
-    // Must not already be approved
-    auto approvals = esc_itr->approvals;
-    check(std::find(approvals.begin(), approvals.end(), approver) == approvals.end(), "You have already approved this escrow");
+    check(!escrow_names.empty(), "escrow_names cannot be empty");
 
-    // Update `escrows` table
-    escrows.modify(esc_itr, approver, [&](auto & row){
-        // if approver is bet.bos, no change, allow proposer to claim 100% of the fund
-        // if approver is BPs, only keep 90% fund for proposer to claim, and BET.BOS will manually execute transfer ACTION in escrow.bos to send fund to each BPs and each auditors
-        if (approver == name("eosio")) {
-            row.ext_asset.quantity.amount = row.ext_asset.quantity.amount * 0.90;
+    // Sorted names walk the `escrowdir` primary index in order
+    vector<name> sorted_names = escrow_names;
+    std::sort(sorted_names.begin(), sorted_names.end());
+    sorted_names.erase(std::unique(sorted_names.begin(), sorted_names.end()), sorted_names.end());
+
+    const uint16_t fee_bps = get_fee_bps(approver);
+    vector<uint8_t> results;
+    results.reserve(sorted_names.size());
+
+    auto dir_itr = directory.end();
+    for (const name escrow_name : sorted_names) {
+        // Step to the next row before falling back to a lookup
+        if (dir_itr != directory.end()) {
+            ++dir_itr;
         }
-        row.approvals.push_back(approver);
-    });
+        if (dir_itr == directory.end() || dir_itr->escrow_name != escrow_name) {
+            dir_itr = directory.find(escrow_name.value);
+        }
+        results.push_back(approve_escrow(dir_itr, approver, fee_bps));
+    }
+
+    // Report per escrow results instead of aborting the batch
+    eosio::action(
+            eosio::permission_level{_self , "active"_n }, // escrow.bos@active
+            _self,
+            "approvelog"_n,
+            make_tuple(approver, sorted_names, results)
+    ).send();
+}
+
+/**
+ * Records the results of `approvemany`, one result code per escrow
+ */
+ACTION escrow::approvelog( const name approver, const vector<name> escrow_names, const vector<uint8_t> results )
+{
+    // Only `escrow.bos` can call `approvelog` action
+    require_auth(_self);
+
+    require_recipient( approver );
 }
 
 ACTION escrow::unapprove( const name escrow_name, const name disapprover )
@@ -128,20 +227,29 @@ ACTION escrow::unapprove( const name escrow_name, const name disapprover )
     require_auth( disapprover );
 
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
+    // Tranches of a milestone escrow are unapproved one by one
+    check(esc_itr->kind != ESCROW_MILESTONES, "Unapprove the tranches of this escrow with unapprovetr");
+
+    // Must have previously approved
+    const uint8_t slot = esc_itr->approval_slot(disapprover);
+    check((esc_itr->approvals & slot) != 0, "You have NOT approved this escrow");
+
     // Update `escrows` table
+    stats_remove(*esc_itr);
     escrows.modify(esc_itr, name{0}, [&](auto & row) {
-        auto existing = std::find(row.approvals.begin(), row.approvals.end(), disapprover);
-        check(existing != row.approvals.end(), "You have NOT approved this escrow");
-        row.approvals.erase(existing);
+        row.approvals &= ~slot;
     });
+    stats_add(*esc_itr);
 }
 
 ACTION escrow::claim( const name escrow_name )
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -151,25 +259,205 @@ ACTION escrow::claim( const name escrow_name )
     // Check if escrow is locked by `approver`
     check(esc_itr->locked == false, "This escrow has been locked by the approver");
 
+    // Tranches of a milestone escrow are claimed one by one
+    check(esc_itr->kind != ESCROW_MILESTONES, "Claim the tranches of this escrow with claimtr");
+
     // Check if escrow has been approved by `approver` or `sender`
-    auto approvals = esc_itr->approvals;
-    check(approvals.size() >= 1, "This escrow has not received the required approvals to claim");
+    check(esc_itr->approvals != 0, "This escrow has not received the required approvals to claim");
+
+    // Vesting escrow pays out what has vested so far
+    if (esc_itr->kind == ESCROW_VESTING) {
+        claim_vested(escrows, esc_itr);
+        return;
+    }
 
     // Transfer escrow funds from `escrow.bos` to `receiver`
-    eosio::action(
-            eosio::permission_level{_self , "active"_n }, // escrow.bos@active
-            esc_itr->ext_asset.contract, // eosio.token
-            "transfer"_n,
-            make_tuple(
-                _self, // from (escrow.bos)
-                esc_itr->receiver, // to (sender)
-                esc_itr->ext_asset.quantity, // quantity (BOS quanity from escrow)
-                esc_itr->memo // memo (escrow memo from `init`)
-            )
-    ).send();
+    send_transfer(directory.get(escrow_name.value).receiver, esc_itr->ext_asset, take_memo(esc_itr->escrow_name));
 
     // Remove `escrow_name` from `escrows` table
-    escrows.erase(esc_itr);
+    erase_escrow(escrows, esc_itr);
+}
+
+/**
+ * Approves the tranche `index` of a milestone escrow
+ */
+ACTION escrow::approvetr( const name escrow_name, const name approver, const uint8_t index )
+{
+    require_auth( approver );
+
+    // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
+    auto esc_itr = escrows.find(escrow_name.value);
+    check(esc_itr != escrows.end(), "Could not find escrow with that name");
+    check(esc_itr->kind == ESCROW_MILESTONES, "This escrow has no tranches");
+
+    // Cannot approve escrow with 0 BOS deposits
+    check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
+
+    // Only `sender` or `approver` can approve escrow
+    const uint8_t slot = esc_itr->approval_slot(approver);
+    check(slot != 0, "You are not allowed to approve this escrow.");
+
+    auto sched_itr = schedules.find(escrow_name.value);
+    check(index < sched_itr->tranches.size(), "Could not find tranche with that index");
+
+    const auto& tr = sched_itr->tranches[index];
+    check(!tr.claimed, "This tranche has already been claimed");
+    check((tr.approvals & slot) == 0, "You have already approved this tranche");
+
+    // Fee of `approver` is withheld from the tranche
+    const uint16_t fee_bps = get_fee_bps(approver);
+    const int64_t amount = deduct_fee(tr.amount, fee_bps > 0 && is_fee_token(esc_itr->ext_asset) ? fee_bps : 0);
+    const extended_asset fee{tr.amount - amount, esc_itr->ext_asset.get_extended_symbol()};
+
+    schedules.modify(sched_itr, eosio::same_payer, [&](auto & row) {
+        row.tranches[index].amount = amount;
+        row.tranches[index].approvals |= slot;
+    });
+
+    // Escrow counts as approved in `stats` while one of its unclaimed tranches is approved
+    const uint8_t approvals = sched_itr->pending_approvals();
+    if (fee.quantity.amount > 0 || approvals != esc_itr->approvals) {
+        stats_remove(*esc_itr);
+        escrows.modify(esc_itr, eosio::same_payer, [&](auto & row) {
+            row.ext_asset -= fee;
+            row.approvals = approvals;
+        });
+        stats_add(*esc_itr);
+    }
+
+    if (fee.quantity.amount > 0) {
+        credit_fee(fee);
+    }
+}
+
+/**
+ * Removes the approval of `disapprover` from the unclaimed tranche `index` of a milestone escrow
+ */
+ACTION escrow::unapprovetr( const name escrow_name, const name disapprover, const uint8_t index )
+{
+    require_auth( disapprover );
+
+    // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
+    auto esc_itr = escrows.find(escrow_name.value);
+    check(esc_itr != escrows.end(), "Could not find escrow with that name");
+    check(esc_itr->kind == ESCROW_MILESTONES, "This escrow has no tranches");
+
+    auto sched_itr = schedules.find(escrow_name.value);
+    check(index < sched_itr->tranches.size(), "Could not find tranche with that index");
+
+    // Must have previously approved a tranche which is not claimed yet
+    const uint8_t slot = esc_itr->approval_slot(disapprover);
+    const auto& tr = sched_itr->tranches[index];
+    check(!tr.claimed, "This tranche has already been claimed");
+    check((tr.approvals & slot) != 0, "You have NOT approved this tranche");
+
+    // Fee withheld by the approval stays in the fee pool, as for `unapprove`
+    schedules.modify(sched_itr, eosio::same_payer, [&](auto & row) {
+        row.tranches[index].approvals &= ~slot;
+    });
+
+    const uint8_t approvals = sched_itr->pending_approvals();
+    if (approvals != esc_itr->approvals) {
+        stats_remove(*esc_itr);
+        escrows.modify(esc_itr, eosio::same_payer, [&](auto & row) {
+            row.approvals = approvals;
+        });
+        stats_add(*esc_itr);
+    }
+}
+
+/**
+ * Pays out the approved and unlocked tranche `index` of a milestone escrow to `receiver`
+ */
+ACTION escrow::claimtr( const name escrow_name, const uint8_t index )
+{
+    // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
+    auto esc_itr = escrows.find(escrow_name.value);
+    check(esc_itr != escrows.end(), "Could not find escrow with that name");
+    check(esc_itr->kind == ESCROW_MILESTONES, "This escrow has no tranches");
+
+    // Escrow must initialized (escrow must be filled with BOS)
+    check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
+
+    // Check if escrow is locked by `approver`
+    check(esc_itr->locked == false, "This escrow has been locked by the approver");
+
+    auto sched_itr = schedules.find(escrow_name.value);
+    check(index < sched_itr->tranches.size(), "Could not find tranche with that index");
+
+    const auto& tr = sched_itr->tranches[index];
+    check(!tr.claimed, "This tranche has already been claimed");
+    check(tr.approvals != 0, "This tranche has not received the required approvals to claim");
+    check(time_point_sec(current_time_point()) >= tr.unlock_at, "This tranche has not unlocked yet");
+
+    const extended_asset payout_asset{tr.amount, esc_itr->ext_asset.get_extended_symbol()};
+    const name receiver = directory.get(escrow_name.value).receiver;
+
+    // Last tranche completes the escrow
+    if (payout_asset == esc_itr->ext_asset) {
+        send_transfer(receiver, payout_asset, take_memo(escrow_name));
+        erase_escrow(escrows, esc_itr);
+        return;
+    }
+
+    // Transfer tranche funds from `escrow.bos` to `receiver`
+    send_transfer(receiver, payout_asset, memos.get(escrow_name.value).memo);
+
+    schedules.modify(sched_itr, eosio::same_payer, [&](auto & row) {
+        row.tranches[index].claimed = true;
+    });
+
+    stats_remove(*esc_itr);
+    escrows.modify(esc_itr, eosio::same_payer, [&](auto & row) {
+        row.ext_asset -= payout_asset;
+        row.approvals = sched_itr->pending_approvals();
+    });
+    stats_add(*esc_itr);
+}
+
+/**
+ * Pays out the claimable escrows among the first `max` escrows of `receiver`
+ */
+ACTION escrow::claimall( const name receiver, const uint32_t max )
+{
+    // Anyone can `claimall`, the work done is bounded by `max`
+    check(max > 0, "max must be greater than zero");
+
+    // Escrows of `receiver` are spread over the scopes of their senders, find them in the directory
+    auto by_receiver = directory.get_index<"byreceiver"_n>();
+    auto dir_itr = by_receiver.lower_bound(receiver.value);
+    uint32_t visited = 0;
+    uint32_t claimed = 0;
+    vector<payout> payouts;
+
+    // Skipped rows count toward `max`, many unapproved escrows of `receiver` cannot make `claimall` unbounded
+    while (dir_itr != by_receiver.end() && dir_itr->receiver == receiver && visited < max) {
+        escrows_table escrows(_self, dir_itr->sender.value);
+        auto esc_itr = escrows.find(dir_itr->escrow_name.value);
+        ++visited;
+
+        // Skip escrows which are locked, unapproved or have not been filled
+        if (!esc_itr->is_claimable()) {
+            ++dir_itr;
+            continue;
+        }
+
+        // Pay escrow funds to `receiver`, coalesced with the other escrows of the same token
+        add_payout(payouts, receiver, esc_itr, take_memo(esc_itr->escrow_name));
+
+        // Remove `escrow_name` from `escrows` & `escrowdir` tables
+        erase_row(escrows, esc_itr);
+        dir_itr = by_receiver.erase(dir_itr);
+        ++claimed;
+    }
+
+    check(claimed > 0, "No claimable escrows for this receiver");
+
+    // Transfer escrow funds from `escrow.bos` to `receiver`, one transfer per token
+    send_payouts(payouts);
 }
 
 /**
@@ -178,6 +466,7 @@ ACTION escrow::claim( const name escrow_name )
 ACTION escrow::cancel(const name escrow_name)
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -187,8 +476,9 @@ ACTION escrow::cancel(const name escrow_name)
     // Can only cancel escrow which contains 0 BOS
     check(0 == esc_itr->ext_asset.quantity.amount, "Amount is not zero, this escrow is locked down");
 
-    // Remove `escrow_name` from `escrows` table
-    escrows.erase(esc_itr);
+    // Remove `escrow_name` from `escrows` & `escrowmemo` tables
+    take_memo(esc_itr->escrow_name);
+    erase_escrow(escrows, esc_itr);
 }
 
 /**
@@ -197,6 +487,7 @@ ACTION escrow::cancel(const name escrow_name)
 ACTION escrow::refund(const name escrow_name)
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -211,23 +502,57 @@ ACTION escrow::refund(const name escrow_name)
 
     // Check if escrow is expired
     time_point_sec time_now = time_point_sec(current_time_point());
-    check(time_now >= esc_itr->expires_at, "Escrow has not expired");
+    check(time_now >= directory.get(escrow_name.value).expires_at, "Escrow has not expired");
 
-    // Transfer back escrow funds from `escrow.bos` to `sender`
-    eosio::action(
-            eosio::permission_level{_self , "active"_n }, // escrow.bos@active
-            esc_itr->ext_asset.contract, // eosio.token
-            "transfer"_n,
-            make_tuple(
-                _self, // from (escrow.bos)
-                esc_itr->sender, // to (sender)
-                esc_itr->ext_asset.quantity, // quantity (BOS quanity from escrow)
-                esc_itr->memo // memo (TO-DO add custom refund message)
-            )
-    ).send();
+    // Transfer back escrow funds from `escrow.bos` to `sender` (TO-DO add custom refund/close message)
+    send_transfer(esc_itr->sender, esc_itr->ext_asset, take_memo(esc_itr->escrow_name));
 
     // Remove `escrow_name` from `escrows` table
-    escrows.erase(esc_itr);
+    erase_escrow(escrows, esc_itr);
+}
+
+/**
+ * Refunds the expired escrows among the first `max_rows` expired rows to their `sender`, oldest expiry first
+ */
+ACTION escrow::sweep(const uint32_t max_rows)
+{
+    // Anyone can `sweep`, the work done is bounded by `max_rows`
+    check(max_rows > 0, "max_rows must be greater than zero");
+
+    time_point_sec time_now = time_point_sec(current_time_point());
+
+    // Expiry of all senders is ordered in the directory
+    auto by_expiry = directory.get_index<"byexpiry"_n>();
+    auto dir_itr = by_expiry.begin();
+    uint32_t visited = 0;
+    uint32_t refunded = 0;
+    vector<payout> payouts;
+
+    // Skipped rows count toward `max_rows`, expired rows left at the head of `byexpiry` cannot make `sweep` unbounded
+    while (dir_itr != by_expiry.end() && visited < max_rows && time_now >= dir_itr->expires_at) {
+        escrows_table escrows(_self, dir_itr->sender.value);
+        auto esc_itr = escrows.find(dir_itr->escrow_name.value);
+        ++visited;
+
+        // Skip escrows which are locked by `approver` or have not been filled
+        if (esc_itr->locked || esc_itr->ext_asset.quantity.amount == 0) {
+            ++dir_itr;
+            continue;
+        }
+
+        // Refund escrow funds to `sender`, coalesced with the other refunds to the same `sender`
+        add_payout(payouts, esc_itr->sender, esc_itr, take_memo(esc_itr->escrow_name));
+
+        // Remove `escrow_name` from `escrows` & `escrowdir` tables
+        erase_row(escrows, esc_itr);
+        dir_itr = by_expiry.erase(dir_itr);
+        ++refunded;
+    }
+
+    check(refunded > 0, "No expired escrows to refund");
+
+    // Transfer back escrow funds from `escrow.bos` to each `sender`
+    send_payouts(payouts);
 }
 
 /**
@@ -236,6 +561,7 @@ ACTION escrow::refund(const name escrow_name)
 ACTION escrow::extend(const name escrow_name, const time_point_sec expires_at)
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -243,17 +569,18 @@ ACTION escrow::extend(const name escrow_name, const time_point_sec expires_at)
     check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
 
     time_point_sec time_now = time_point_sec(current_time_point());
+    auto dir_itr = directory.find(escrow_name.value);
 
     // `approver` may extend or shorten the time
     // `sender` may only extend
     if ( has_auth( esc_itr->sender ) ) {
-        check(expires_at > esc_itr->expires_at, "You may only extend the expiry");
+        check(expires_at > dir_itr->expires_at, "You may only extend the expiry");
     } else {
         require_auth( esc_itr->approver );
     }
 
-    // Modify `escrows` table with new `expire_at` value
-    escrows.modify(esc_itr, eosio::same_payer, [&](auto & row){
+    // Modify `escrowdir` table with new `expire_at` value, the `byexpiry` order of `sweep` follows
+    directory.modify(dir_itr, eosio::same_payer, [&](auto & row){
         row.expires_at = expires_at;
     });
 }
@@ -264,6 +591,7 @@ ACTION escrow::extend(const name escrow_name, const time_point_sec expires_at)
 ACTION escrow::close(const name escrow_name)
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -273,21 +601,11 @@ ACTION escrow::close(const name escrow_name)
     // Escrow must be initialized (transfer BOS to escrow.bos)
     check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
 
-    // Transfer back escrow funds from `escrow.bos` to `sender`
-    eosio::action(
-            eosio::permission_level{_self , "active"_n }, // escrow.bos@active
-            esc_itr->ext_asset.contract, // eosio.token
-            "transfer"_n,
-            make_tuple(
-                _self, // from (escrow.bos)
-                esc_itr->sender, // to (sender)
-                esc_itr->ext_asset.quantity, // quantity (BOS quanity from escrow)
-                esc_itr->memo // memo (TO-DO add custom close message)
-            )
-    ).send();
+    // Transfer back escrow funds from `escrow.bos` to `sender` (TO-DO add custom refund/close message)
+    send_transfer(esc_itr->sender, esc_itr->ext_asset, take_memo(esc_itr->escrow_name));
 
     // Remove `escrow_name` from `escrows` table
-    escrows.erase(esc_itr);
+    erase_escrow(escrows, esc_itr);
 }
 
 /**
@@ -296,6 +614,7 @@ ACTION escrow::close(const name escrow_name)
 ACTION escrow::lock(const name escrow_name, const bool locked)
 {
     // Check if `escrow_name` already exists
+    escrows_table escrows = get_shard(escrow_name);
     auto esc_itr = escrows.find(escrow_name.value);
     check(esc_itr != escrows.end(), "Could not find escrow with that name");
 
@@ -306,19 +625,665 @@ ACTION escrow::lock(const name escrow_name, const bool locked)
     check(esc_itr->ext_asset.quantity.amount > 0, "This has not been initialized with a transfer");
 
     // Modify `escrows` table with lock boolean (true/false)
+    stats_remove(*esc_itr);
     escrows.modify(esc_itr, eosio::same_payer, [&](auto & row) {
         row.locked = locked;
     });
+    stats_add(*esc_itr);
+}
+
+/**
+ * Sets the escrow policy, replacing the compiled in defaults
+ */
+ACTION escrow::setconfig( const vector<name> senders,
+                          const vector<name> approvers,
+                          const name         token_contract,
+                          const symbol       token_symbol,
+                          const uint32_t     max_expiry )
+{
+    // Only `escrow.bos` can call `setconfig` action
+    require_auth(_self);
+
+    check(is_account(token_contract), "token contract account does not exist");
+    check(token_symbol.is_valid(), "invalid token symbol");
+    check(max_expiry > 0, "max_expiry must be greater than zero");
+
+    config_singleton config_table(_self, _self.value);
+    config_table.set(config_row{senders, approvers, token_contract, token_symbol, max_expiry}, _self);
+    _config.reset();
+}
+
+/**
+ * Adds `sym` of `contract` to the tokens which can be escrowed
+ */
+ACTION escrow::addtoken( const name contract, const symbol sym )
+{
+    // Only `escrow.bos` can call `addtoken` action
+    require_auth(_self);
+
+    check(is_account(contract), "token contract account does not exist");
+    check(sym.is_valid(), "invalid token symbol");
+
+    tokens_table tokens(_self, contract.value);
+    check(tokens.find(sym.code().raw()) == tokens.end(), "token is already accepted");
+
+    tokens.emplace(_self, [&](auto & row) {
+        row.sym = sym;
+    });
+}
+
+/**
+ * Removes `sym` of `contract` from the tokens which can be escrowed, existing escrows are not affected
+ */
+ACTION escrow::rmtoken( const name contract, const symbol sym )
+{
+    // Only `escrow.bos` can call `rmtoken` action
+    require_auth(_self);
+
+    tokens_table tokens(_self, contract.value);
+    auto token_itr = tokens.find(sym.code().raw());
+    check(token_itr != tokens.end(), "token is not accepted");
+
+    tokens.erase(token_itr);
+}
+
+/**
+ * Sets the fee in basis points withheld from an escrow when `approver` approves it
+ */
+ACTION escrow::setfee(const name approver, const uint16_t fee_bps)
+{
+    // Only `escrow.bos` can call `setfee` action
+    require_auth(_self);
+
+    // A fee must leave something to claim, an approved escrow keeps a non-zero amount
+    check(fee_bps < BPS_DENOMINATOR, "fee_bps must be less than 10000");
+
+    auto fee_itr = fees.find(approver.value);
+    if (fee_itr == fees.end()) {
+        fees.emplace(_self, [&](auto & row) {
+            row.approver = approver;
+            row.fee_bps = fee_bps;
+        });
+    } else {
+        fees.modify(fee_itr, eosio::same_payer, [&](auto & row) {
+            row.fee_bps = fee_bps;
+        });
+    }
+}
+
+/**
+ * Sets the share weight of `account` in the fee pool, fees accrued so far are kept
+ */
+ACTION escrow::setshares( const name account, const uint64_t shares )
+{
+    // Only `escrow.bos` can call `setshares` action
+    require_auth(_self);
+
+    check(is_account(account), "account does not exist");
+
+    auto& pool = get_fee_pool();
+    auto share_itr = fee_shares.find(account.value);
+
+    if (share_itr == fee_shares.end()) {
+        check(shares > 0, "account has no shares");
+        fee_shares.emplace(_self, [&](auto & row) {
+            row.account = account;
+        });
+        share_itr = fee_shares.find(account.value);
+    }
+
+    const int64_t pending = settle_fees(*share_itr);
+    pool.total_shares = pool.total_shares - share_itr->shares + shares;
+
+    if (shares == 0 && pending == 0) {
+        fee_shares.erase(share_itr);
+    } else {
+        fee_shares.modify(share_itr, eosio::same_payer, [&](auto & row) {
+            row.shares = shares;
+            row.pending = pending;
+            row.reward_debt = static_cast<uint128_t>(shares) * pool.acc_per_share / FEE_PRECISION;
+        });
+    }
+
+    // Fees withheld while nobody had shares go to the current beneficiaries, `account` included
+    // Spread after `reward_debt` is set, otherwise the debt of `account` cancels its part of these fees
+    if (pool.total_shares > 0 && pool.undistributed > 0) {
+        pool.acc_per_share += static_cast<uint128_t>(pool.undistributed) * FEE_PRECISION / pool.total_shares;
+        pool.undistributed = 0;
+    }
+}
+
+/**
+ * Pays out the fees accrued by `account` in the fee pool
+ */
+ACTION escrow::claimfees( const name account )
+{
+    require_auth(account);
+
+    auto share_itr = fee_shares.find(account.value);
+    check(share_itr != fee_shares.end(), "account has no shares in the fee pool");
+
+    auto& pool = get_fee_pool();
+    const int64_t pending = settle_fees(*share_itr);
+    check(pending > 0, "No fees to claim");
+
+    // Transfer accrued fees from `escrow.bos` to `account`
+    send_transfer(account, extended_asset{asset{pending, pool.token_symbol}, pool.token_contract}, "escrow.bos fee distribution");
+
+    if (share_itr->shares == 0) {
+        fee_shares.erase(share_itr);
+        return;
+    }
+
+    fee_shares.modify(share_itr, eosio::same_payer, [&](auto & row) {
+        row.pending = 0;
+        row.reward_debt = static_cast<uint128_t>(row.shares) * pool.acc_per_share / FEE_PRECISION;
+    });
 }
 
-ACTION escrow::clean()
+/**
+ * Removes up to `max_rows` escrows, resuming from the cursor left by the previous `clean`
+ */
+ACTION escrow::clean(const uint32_t max_rows)
 {
     // Only `escrow.bos` can call `clean` action
     require_auth(_self);
 
-    // Remove all rows from `escrows` table
-    auto itr = escrows.begin();
-    while (itr != escrows.end()){
-        itr = escrows.erase(itr);
+    check(max_rows > 0, "max_rows must be greater than zero");
+
+    clean_singleton clean_state(_self, _self.value);
+    auto state = clean_state.get_or_default();
+
+    // Remove up to `max_rows` rows from `escrows` table, walking the directory of all scopes
+    uint32_t removed = 0;
+    auto itr = directory.lower_bound(state.cursor);
+    while (itr != directory.end() && removed < max_rows) {
+        escrows_table escrows(_self, itr->sender.value);
+        auto esc_itr = escrows.find(itr->escrow_name.value);
+        take_memo(itr->escrow_name);
+        erase_row(escrows, esc_itr);
+        itr = directory.erase(itr);
+        ++removed;
+    }
+    state.removed += removed;
+
+    // Rows created behind the cursor during a clean are picked up by starting over from the first row
+    if (itr == directory.end()) {
+        itr = directory.begin();
+    }
+
+    print("clean removed ", removed, " rows (", state.removed, " in total), ", get_stats().open, " rows remaining");
+
+    if (itr == directory.end()) {
+        clean_state.remove();
+    } else {
+        state.cursor = itr->primary_key();
+        clean_state.set(state, _self);
+    }
+}
+
+/**
+ * Moves up to `max_rows` escrows written before escrows were scoped by sender to the scope of their sender
+ */
+ACTION escrow::migrate(const uint32_t max_rows)
+{
+    // Only `escrow.bos` can call `migrate` action
+    require_auth(_self);
+
+    check(max_rows > 0, "max_rows must be greater than zero");
+
+    // Moved rows are erased, the first remaining row is where the next call resumes
+    // Senders do not authorize the migration, escrow.bos pays for the RAM of the new rows
+    legacy_escrows_table legacy(_self, _self.value);
+    uint32_t moved = 0;
+    auto itr = legacy.begin();
+    while (itr != legacy.end() && moved < max_rows) {
+        directory.emplace(_self, [&](auto & row) {
+            row.escrow_name = itr->escrow_name;
+            row.sender = itr->sender;
+            row.receiver = itr->receiver;
+            row.expires_at = itr->expires_at;
+        });
+
+        escrows_table escrows(_self, itr->sender.value);
+        auto esc_itr = escrows.emplace(_self, [&](auto & row) {
+            row.escrow_name = itr->escrow_name;
+            row.sender = itr->sender;
+            row.approver = itr->approver;
+            for (const name account : itr->approvals) {
+                row.approvals |= row.approval_slot(account);
+            }
+            row.ext_asset = itr->ext_asset;
+            row.created_at = itr->created_at;
+            row.locked = itr->locked;
+            row.kind = ESCROW_SINGLE;
+        });
+        stats_add(*esc_itr);
+
+        memos.emplace(_self, [&](auto & row) {
+            row.escrow_name = itr->escrow_name;
+            row.memo = itr->memo;
+        });
+
+        itr = legacy.erase(itr);
+        ++moved;
+    }
+
+    print("migrate moved ", moved, " rows, ", itr == legacy.end() ? "no rows remaining" : "more rows remaining");
+}
+
+bool escrow::parse_escrow_name( const string& memo, name& escrow_name )
+{
+    // Only accept memos that are a valid `name`, any other memo keeps the sender lookup
+    if (memo.empty() || memo.size() > 12 || memo.back() == '.') {
+        return false;
+    }
+    for (const char c : memo) {
+        if (!((c >= 'a' && c <= 'z') || (c >= '1' && c <= '5') || c == '.')) {
+            return false;
+        }
+    }
+    escrow_name = name{memo};
+    return true;
+}
+
+const escrow::config_row& escrow::get_config()
+{
+    // Read once per action, falls back to the compiled in defaults until `setconfig` is called
+    if (!_config) {
+        config_singleton config_table(_self, _self.value);
+        _config = config_table.get_or_default(config_row{
+            {"bet.bos"_n},
+            {"eosio"_n},
+            "eosio.token"_n,
+            symbol{"BOS", 4},
+            SIX_MONTHS_IN_SECONDS
+        });
+    }
+    return *_config;
+}
+
+bool escrow::is_allowed( const vector<name>& whitelist, const name account )
+{
+    // An empty whitelist allows any account
+    return whitelist.empty() || std::find(whitelist.begin(), whitelist.end(), account) != whitelist.end();
+}
+
+bool escrow::is_token_allowed( const name contract, const symbol sym )
+{
+    // The configured token is always accepted, other tokens are looked up in the `tokens` scope of their contract
+    const auto& config = get_config();
+    if (contract == config.token_contract && sym == config.token_symbol) {
+        return true;
+    }
+
+    tokens_table tokens(_self, contract.value);
+    auto token_itr = tokens.find(sym.code().raw());
+    return token_itr != tokens.end() && token_itr->sym == sym;
+}
+
+uint16_t escrow::get_fee_bps( const name approver )
+{
+    // `eosio` keeps its 10% cut until a fee is set for it
+    auto fee_itr = fees.find(approver.value);
+    if (fee_itr == fees.end()) {
+        return approver == "eosio"_n ? DEFAULT_EOSIO_FEE_BPS : 0;
+    }
+    return fee_itr->fee_bps;
+}
+
+escrow::fee_pool_row& escrow::get_fee_pool()
+{
+    // Pool token is the configured token when the pool is first used
+    if (!_fee_pool) {
+        const auto& config = get_config();
+        fee_pool_singleton fee_pool_table(_self, _self.value);
+        _fee_pool = fee_pool_table.get_or_default(fee_pool_row{config.token_contract, config.token_symbol});
+    }
+    return *_fee_pool;
+}
+
+bool escrow::is_fee_token( const extended_asset& ext_asset )
+{
+    // Fees are only withheld in the pool token, escrows of the tokens added with `addtoken` are approved without fee
+    const auto& pool = get_fee_pool();
+    return ext_asset.contract == pool.token_contract && ext_asset.quantity.symbol == pool.token_symbol;
+}
+
+void escrow::credit_fee( const extended_asset& fee )
+{
+    auto& pool = get_fee_pool();
+    check(is_fee_token(fee), "fee is not in the token of the fee pool");
+
+    // Reward per share, O(1) regardless of the number of beneficiaries
+    if (pool.total_shares == 0) {
+        pool.undistributed += fee.quantity.amount;
+    } else {
+        pool.acc_per_share += static_cast<uint128_t>(fee.quantity.amount + pool.undistributed) * FEE_PRECISION / pool.total_shares;
+        pool.undistributed = 0;
+    }
+}
+
+int64_t escrow::settle_fees( const fee_share_row& share )
+{
+    // Fees accrued since the last settlement plus the fees settled before
+    const uint128_t accrued = static_cast<uint128_t>(share.shares) * get_fee_pool().acc_per_share / FEE_PRECISION;
+    return share.pending + static_cast<int64_t>(accrued - share.reward_debt);
+}
+
+int64_t escrow::deduct_fee( const int64_t amount, const uint16_t fee_bps )
+{
+    // Exact integer math, int128 intermediate cannot overflow for any int64 amount
+    const int64_t kept = static_cast<int64_t>( static_cast<int128_t>(amount) * (BPS_DENOMINATOR - fee_bps) / BPS_DENOMINATOR );
+
+    // Dust amounts keep 1 unit, an approved escrow emptied by its fee would look un-filled to `byfunded`
+    return kept == 0 && amount > 0 ? 1 : kept;
+}
+
+void escrow::check_init( const name sender )
+{
+    // Validate user input
+    require_auth( sender );
+
+    // Enforce `sender` whitelist (`bet.bos` by default)
+    // Empty the whitelists with `setconfig` once escrow.bos is ready for public use
+    const auto& config = get_config();
+    check(is_allowed(config.senders, sender), "sender is not allowed to init an escrow");
+
+    // Notify the following accounts
+    require_recipient( sender );
+}
+
+void escrow::check_account( const name account, const char* error )
+{
+    // Receivers & approvers repeat across a funding round, only check each account once per action
+    if (std::find(known_accounts.begin(), known_accounts.end(), account) == known_accounts.end()) {
+        check(is_account(account), error);
+        known_accounts.push_back(account);
+    }
+}
+
+void escrow::init_escrow( const name sender, const escrow_spec& spec, const time_point_sec time_now, const uint8_t kind )
+{
+    // Validate user input
+    check_account( spec.receiver, "receiver account does not exist" );
+    check_account( spec.approver, "approver account does not exist" );
+    check( sender != _self, "escrow.bos cannot be the sender of an escrow" );
+    check( sender != spec.receiver, "cannot escrow to self" );
+    check( spec.receiver != spec.approver, "receiver cannot be approver" );
+    check( spec.escrow_name.length() > 2, "escrow name should be at least 3 characters long.");
+
+    const auto& config = get_config();
+
+    // Validate expire time_point_sec
+    check(spec.expires_at > time_now, "expires_at must be a value in the future.");
+    time_point_sec max_expires_at = time_now + config.max_expiry;
+    check(spec.expires_at <= max_expires_at, "expires_at must be within the maximum expiry from now.");
+
+    // Enforce `approver` whitelist (`eosio` by default)
+    check(is_allowed(config.approvers, spec.approver), "approver is not allowed to approve an escrow");
+
+    // Notify the following accounts
+    require_recipient( spec.receiver );
+    require_recipient( spec.approver );
+
+    // Set Escrow deposit as the configured token, `eosio.token` BOS by default (Extended Asset)
+    extended_asset zero_asset{{0, config.token_symbol}, config.token_contract};
+
+    // Escrow name must be unique across all scopes, including the rows `migrate` has not moved yet
+    legacy_escrows_table legacy(_self, _self.value);
+    check(directory.find(spec.escrow_name.value) == directory.end() && legacy.find(spec.escrow_name.value) == legacy.end(),
+        "escrow with same name already exists.");
+
+    // Update `escrowdir` table
+    directory.emplace(sender, [&](auto & row) {
+        row.escrow_name = spec.escrow_name;
+        row.sender = sender;
+        row.receiver = spec.receiver;
+        row.expires_at = spec.expires_at;
+    });
+
+    // Update `escrows` table, in the scope of `sender`
+    escrows_table escrows(_self, sender.value);
+    auto esc_itr = escrows.emplace(sender, [&](auto & row) {
+        row.escrow_name = spec.escrow_name;
+        row.sender = sender;
+        row.approver = spec.approver;
+        row.ext_asset = zero_asset;
+        row.created_at = time_now;
+        row.locked = false;
+        row.kind = kind;
+    });
+    stats_add(*esc_itr);
+
+    // Memo is only read on payout, keep it out of the `escrows` row
+    memos.emplace(sender, [&](auto & row) {
+        row.escrow_name = spec.escrow_name;
+        row.memo = spec.memo;
+    });
+}
+
+void escrow::claim_vested( escrows_table& escrows, const escrows_table::const_iterator& esc_itr )
+{
+    // Claimable balance is computed at claim time, O(1) however often the receiver claims
+    auto vest_itr = vestings.find(esc_itr->escrow_name.value);
+    const int64_t total = esc_itr->ext_asset.quantity.amount + vest_itr->claimed;
+    const int64_t payable = vest_itr->vested(total, time_point_sec(current_time_point())) - vest_itr->claimed;
+    check(payable > 0, "Nothing has vested since the last claim");
+
+    const extended_asset payout_asset{payable, esc_itr->ext_asset.get_extended_symbol()};
+    const name receiver = directory.get(esc_itr->escrow_name.value).receiver;
+
+    // Fully vested & claimed completes the escrow
+    if (payout_asset == esc_itr->ext_asset) {
+        send_transfer(receiver, payout_asset, take_memo(esc_itr->escrow_name));
+        erase_escrow(escrows, esc_itr);
+        return;
+    }
+
+    // Transfer vested funds from `escrow.bos` to `receiver`
+    send_transfer(receiver, payout_asset, memos.get(esc_itr->escrow_name.value).memo);
+
+    vestings.modify(vest_itr, eosio::same_payer, [&](auto & row) {
+        row.claimed += payable;
+    });
+
+    stats_remove(*esc_itr);
+    escrows.modify(esc_itr, eosio::same_payer, [&](auto & row) {
+        row.ext_asset -= payout_asset;
+    });
+    stats_add(*esc_itr);
+}
+
+void escrow::check_deposit( const escrow_row& row, const asset& quantity )
+{
+    // One deposit funds the whole schedule of a milestone escrow
+    if (row.kind == ESCROW_MILESTONES) {
+        check(quantity.amount == schedules.get(row.escrow_name.value).total(), "Deposit must equal the sum of the tranches");
+    }
+}
+
+uint8_t escrow::approve_escrow( const directory_table::const_iterator& dir_itr, const name approver, const uint16_t fee_bps )
+{
+    if (dir_itr == directory.end()) {
+        return NOT_FOUND;
+    }
+
+    escrows_table escrows(_self, dir_itr->sender.value);
+    auto esc_itr = escrows.find(dir_itr->escrow_name.value);
+
+    // Cannot approve escrow with 0 BOS deposits
+    if (esc_itr->ext_asset.quantity.amount == 0) {
+        return NOT_FUNDED;
+    }
+
+    // Tranches of a milestone escrow are approved one by one
+    if (esc_itr->kind == ESCROW_MILESTONES) {
+        return HAS_TRANCHES;
+    }
+
+    // Only `sender` or `approver` can approve escrow
+    const uint8_t slot = esc_itr->approval_slot(approver);
+    if (slot == 0) {
+        return NOT_ALLOWED;
+    }
+
+    // Must not already be approved
+    if (esc_itr->approvals & slot) {
+        return ALREADY_APPROVED;
+    }
+
+    // if approver is bet.bos, no change, allow proposer to claim 100% of the fund
+    // if approver is BPs, only keep 90% fund for proposer to claim, the withheld 10% is credited to the fee pool of the BPs and auditors
+    const int64_t amount = deduct_fee(esc_itr->ext_asset.quantity.amount, fee_bps > 0 && is_fee_token(esc_itr->ext_asset) ? fee_bps : 0);
+    const extended_asset fee = esc_itr->ext_asset - extended_asset{amount, esc_itr->ext_asset.get_extended_symbol()};
+
+    // Update `escrows` table
+    stats_remove(*esc_itr);
+    escrows.modify(esc_itr, approver, [&](auto & row){
+        row.ext_asset.quantity.amount = amount;
+        row.approvals |= slot;
+    });
+    stats_add(*esc_itr);
+
+    if (fee.quantity.amount > 0) {
+        credit_fee(fee);
+    }
+    return APPROVED;
+}
+
+escrow::escrows_table escrow::get_shard( const name escrow_name )
+{
+    // Escrows are scoped by `sender`, the directory resolves the scope of `escrow_name`
+    auto dir_itr = directory.find(escrow_name.value);
+    check(dir_itr != directory.end(), "Could not find escrow with that name");
+    return escrows_table(_self, dir_itr->sender.value);
+}
+
+void escrow::erase_escrow( escrows_table& escrows, const escrows_table::const_iterator& esc_itr )
+{
+    // Remove `escrow_name` from `escrowdir` & `escrows` tables
+    directory.erase(directory.find(esc_itr->escrow_name.value));
+    erase_row(escrows, esc_itr);
+}
+
+void escrow::erase_row( escrows_table& escrows, const escrows_table::const_iterator& esc_itr )
+{
+    // Remove the tranches of a milestone escrow & the schedule of a vesting escrow with its row
+    if (esc_itr->kind == ESCROW_MILESTONES) {
+        schedules.erase(schedules.find(esc_itr->escrow_name.value));
+    } else if (esc_itr->kind == ESCROW_VESTING) {
+        vestings.erase(vestings.find(esc_itr->escrow_name.value));
+    }
+    stats_remove(*esc_itr);
+    escrows.erase(esc_itr);
+}
+
+escrow::stats_row& escrow::get_stats()
+{
+    if (!_stats) {
+        stats_singleton stats_table(_self, _self.value);
+        _stats = stats_table.get_or_default();
+    }
+    return *_stats;
+}
+
+void escrow::stats_add( const escrow_row& row )
+{
+    update_stats(row, 1);
+}
+
+void escrow::stats_remove( const escrow_row& row )
+{
+    update_stats(row, -1);
+}
+
+void escrow::update_stats( const escrow_row& row, const int8_t delta )
+{
+    auto& stats = get_stats();
+    stats.open += delta;
+    stats.approved += row.approvals != 0 ? delta : 0;
+    stats.locked += row.locked ? delta : 0;
+
+    if (row.ext_asset.quantity.amount == 0) {
+        return;
+    }
+    stats.funded += delta;
+
+    // Total value held per token, tokens without funded escrows are dropped
+    const int64_t amount = row.ext_asset.quantity.amount * delta;
+    for (auto itr = stats.held.begin(); itr != stats.held.end(); ++itr) {
+        if (itr->get_extended_symbol() == row.ext_asset.get_extended_symbol()) {
+            itr->quantity.amount += amount;
+            if (itr->quantity.amount == 0) {
+                stats.held.erase(itr);
+            }
+            return;
+        }
+    }
+    stats.held.push_back(extended_asset{amount, row.ext_asset.get_extended_symbol()});
+}
+
+string escrow::take_memo( const name escrow_name )
+{
+    // Read and remove the memo of `escrow_name` from `escrowmemo` table
+    string memo;
+    auto memo_itr = memos.find(escrow_name.value);
+    if (memo_itr != memos.end()) {
+        memo = memo_itr->memo;
+        memos.erase(memo_itr);
+    }
+    return memo;
+}
+
+void escrow::send_transfer( const name to, const extended_asset& ext_asset, const string& memo )
+{
+    // Transfer funds from `escrow.bos` to `to`
+    eosio::action(
+            eosio::permission_level{_self , "active"_n }, // escrow.bos@active
+            ext_asset.contract, // eosio.token
+            "transfer"_n,
+            make_tuple(
+                _self, // from (escrow.bos)
+                to, // to (receiver or sender)
+                ext_asset.quantity, // quantity (BOS quanity from escrow)
+                memo // memo (escrow memo from `init`)
+            )
+    ).send();
+}
+
+template<typename Iterator>
+void escrow::add_payout( vector<payout>& payouts, const name to, const Iterator& esc_itr, string memo )
+{
+    // Sum with an existing payout of the same token to the same account
+    for (auto& existing : payouts) {
+        if (existing.to == to && existing.ext_asset.get_extended_symbol() == esc_itr->ext_asset.get_extended_symbol()) {
+            existing.ext_asset += esc_itr->ext_asset;
+            existing.escrow_names.push_back(esc_itr->escrow_name);
+            return;
+        }
+    }
+    payouts.push_back(payout{to, esc_itr->ext_asset, {esc_itr->escrow_name}, std::move(memo)});
+}
+
+void escrow::send_payouts( const vector<payout>& payouts )
+{
+    for (const auto& p : payouts) {
+        // A single escrow keeps its memo from `init`, coalesced escrows list their names instead
+        if (p.escrow_names.size() == 1) {
+            send_transfer(p.to, p.ext_asset, p.memo);
+            continue;
+        }
+
+        string memo = "escrows";
+        for (const name escrow_name : p.escrow_names) {
+            const string next = " " + escrow_name.to_string();
+            if (memo.size() + next.size() + 4 > MAX_MEMO_SIZE) {
+                memo += " ...";
+                break;
+            }
+            memo += next;
+        }
+        send_transfer(p.to, p.ext_asset, memo);
     }
 }
@@ -0,0 +1,820 @@
+#include "tester.hpp"
+
+// Behaviour suite of the escrow actions, ported from contract_spec.rb
+// The scenarios of the spec are kept in order, escrow names replace the `key` of the original contract
+
+namespace {
+
+    const symbol BOS{"BOS", 4};
+    const name SENDER1 = "sender1"_n;
+    const name SENDER2 = "sender2"_n;
+    const name SENDER3 = "sender3"_n;
+    const name SENDER4 = "sender4"_n;
+    const name RECEIVER1 = "receiver1"_n;
+    const name ARB1 = "arb1"_n;
+    const name ARB2 = "arb2"_n;
+
+    asset bos( int64_t amount ) { return asset{amount, BOS}; }
+
+    constexpr uint32_t DAY = 24 * 60 * 60;
+
+    time_point_sec from_now( uint32_t seconds ) { return time_point_sec(escrow_tester::START + seconds); }
+
+    const time_point_sec EXPIRES = from_now(30 * DAY);
+
+    // Accounts of the spec, senders hold 1000.0000 BOS, `arb1` & `arb2` approve without fee
+    void setup( escrow_tester& t ) {
+        t.create_accounts({SENDER1, SENDER2, SENDER3, SENDER4, RECEIVER1, ARB1, ARB2});
+        for (const name sender : {SENDER1, SENDER2, SENDER3, SENDER4}) {
+            t.issue(sender, bos(10000000));
+        }
+        t.push(escrow_tester::SELF, &escrow::setconfig,
+            vector<name>{SENDER1, SENDER2, SENDER3, SENDER4},
+            vector<name>{ARB1, ARB2, "eosio"_n},
+            escrow_tester::TOKEN, BOS, escrow_tester::SIX_MONTHS_IN_SECONDS);
+    }
+
+    void init( escrow_tester& t, name sender, name escrow_name, name approver = ARB1, time_point_sec expires_at = EXPIRES, string memo = "some memo" ) {
+        t.push(sender, &escrow::init, sender, RECEIVER1, approver, escrow_name, expires_at, memo);
+    }
+
+    // Escrow funded with `amount`, addressed by memo
+    void init_funded( escrow_tester& t, name sender, name escrow_name, int64_t amount, name approver = ARB1 ) {
+        init(t, sender, escrow_name, approver);
+        t.transfer(sender, escrow_tester::SELF, bos(amount), escrow_name.to_string());
+    }
+}
+
+// init
+
+ESCROW_TEST(init_requires_sender_authority) {
+    setup(t);
+    REQUIRE_ERROR("missing authority of sender1",
+        t.push(SENDER2, &escrow::init, SENDER1, RECEIVER1, ARB1, "escrow1"_n, EXPIRES, string("some memo")));
+}
+
+ESCROW_TEST(init_creates_an_empty_escrow) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+
+    const auto row = t.get_escrow("escrow1"_n);
+    REQUIRE(row.has_value());
+    REQUIRE_EQUAL(row->sender, SENDER1);
+    REQUIRE_EQUAL(row->approver, ARB1);
+    REQUIRE_EQUAL(row->approvals, 0);
+    REQUIRE_EQUAL(row->ext_asset, (eosio::extended_asset{bos(0), escrow_tester::TOKEN}));
+    REQUIRE_EQUAL(row->locked, false);
+
+    // `receiver` & `expires_at` are kept once, in the directory
+    const auto dir = t.get_directory("escrow1"_n);
+    REQUIRE_EQUAL(dir->sender, SENDER1);
+    REQUIRE_EQUAL(dir->receiver, RECEIVER1);
+    REQUIRE_EQUAL(dir->expires_at, EXPIRES);
+    REQUIRE_EQUAL(*t.get_memo("escrow1"_n), string("some memo"));
+
+    REQUIRE_ERROR("escrow with same name already exists.", init(t, SENDER1, "escrow1"_n, ARB1, EXPIRES, "some other memo"));
+}
+
+ESCROW_TEST(init_validates_its_input) {
+    setup(t);
+    REQUIRE_ERROR("sender is not allowed to init an escrow",
+        t.push(RECEIVER1, &escrow::init, RECEIVER1, SENDER1, ARB1, "escrow1"_n, EXPIRES, string("memo")));
+    REQUIRE_ERROR("approver is not allowed to approve an escrow", init(t, SENDER1, "escrow1"_n, SENDER2));
+    REQUIRE_ERROR("receiver account does not exist",
+        t.push(SENDER1, &escrow::init, SENDER1, "nobody"_n, ARB1, "escrow1"_n, EXPIRES, string("memo")));
+    REQUIRE_ERROR("escrow name should be at least 3 characters long.", init(t, SENDER1, "es"_n));
+    REQUIRE_ERROR("expires_at must be a value in the future.", init(t, SENDER1, "escrow1"_n, ARB1, from_now(0)));
+    REQUIRE_ERROR("expires_at must be within the maximum expiry from now.",
+        init(t, SENDER1, "escrow1"_n, ARB1, from_now(escrow_tester::SIX_MONTHS_IN_SECONDS + 1)));
+}
+
+// transfer
+
+ESCROW_TEST(transfer_requires_sender_authority) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+    REQUIRE_ERROR("missing authority of sender1", t.transfer_as(SENDER2, SENDER1, escrow_tester::SELF, bos(50000), "here is a memo"));
+}
+
+ESCROW_TEST(transfer_without_an_escrow_is_cancelled) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+    REQUIRE_ERROR("Could not find existing escrow to deposit to, transfer cancelled",
+        t.transfer(SENDER2, escrow_tester::SELF, bos(50000), "here is a memo"));
+    REQUIRE_EQUAL(t.balance(SENDER2), 10000000);
+}
+
+ESCROW_TEST(transfer_fills_the_empty_escrow_of_the_sender) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "here is a memo");
+
+    REQUIRE_EQUAL(t.balance(SENDER1), 9950000);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 50000);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(50000));
+}
+
+ESCROW_TEST(transfer_memo_selects_the_escrow) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+    init(t, SENDER1, "escrow2"_n);
+    REQUIRE_ERROR("You have several empty escrows, set the escrow name as the transfer memo",
+        t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "here is a memo"));
+
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow2");
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(0));
+    REQUIRE_EQUAL(t.get_escrow("escrow2"_n)->ext_asset.quantity, bos(50000));
+
+    REQUIRE_ERROR("This escrow has already been filled", t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow2"));
+
+    // The escrow named by the memo belongs to another sender, the empty escrow of `sender2` is filled instead
+    init(t, SENDER2, "escrow3"_n);
+    t.transfer(SENDER2, escrow_tester::SELF, bos(40000), "escrow1");
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(0));
+    REQUIRE_EQUAL(t.get_escrow("escrow3"_n)->ext_asset.quantity, bos(40000));
+
+    // The only empty escrow left is found without memo
+    t.transfer(SENDER1, escrow_tester::SELF, bos(60000), "");
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(60000));
+}
+
+ESCROW_TEST(transfer_rejects_tokens_not_accepted) {
+    setup(t);
+    t.create_accounts({"other.token"_n});
+    t.issue(SENDER1, bos(50000), "other.token"_n);
+    t.issue(SENDER1, asset{50000, symbol{"EOS", 4}});
+    init(t, SENDER1, "escrow1"_n);
+
+    REQUIRE_ERROR("This token is not accepted by the escrow", t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow1", "other.token"_n));
+    REQUIRE_ERROR("This token is not accepted by the escrow", t.transfer(SENDER1, escrow_tester::SELF, asset{50000, symbol{"EOS", 4}}, "escrow1"));
+    REQUIRE_EQUAL(t.balance(SENDER1, BOS, "other.token"_n), 50000);
+
+    t.push(escrow_tester::SELF, &escrow::addtoken, "other.token"_n, BOS);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow1", "other.token"_n);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.contract, "other.token"_n);
+
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1, BOS, "other.token"_n), 50000);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 0);
+}
+
+// approve
+
+ESCROW_TEST(approve) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+
+    REQUIRE_ERROR("missing authority of arb1", t.push(SENDER2, &escrow::approve, "escrow1"_n, ARB1));
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::approve, "escrow4"_n, ARB1));
+
+    init(t, SENDER2, "escrow2"_n, ARB1, EXPIRES, "another empty escrow");
+    REQUIRE_ERROR("This has not been initialized with a transfer", t.push(ARB1, &escrow::approve, "escrow2"_n, ARB1));
+
+    REQUIRE_ERROR("You are not allowed to approve this escrow.", t.push(ARB2, &escrow::approve, "escrow1"_n, ARB2));
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    REQUIRE_ERROR("You have already approved this escrow", t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1));
+
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->approvals, escrow_tester::approved_by_approver());
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(50000));
+    REQUIRE_EQUAL(t.get_escrow("escrow2"_n)->approvals, 0);
+}
+
+ESCROW_TEST(approvemany_reports_each_escrow) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    init_funded(t, SENDER2, "escrow2"_n, 50000, ARB2);
+    init(t, SENDER3, "escrow3"_n);
+
+    t.push(ARB1, &escrow::approvemany, ARB1, vector<name>{"escrow3"_n, "escrow1"_n, "escrow2"_n, "unknown"_n, "escrow1"_n});
+
+    REQUIRE_EQUAL(t.sent_actions().size(), 1u);
+    const auto [approver, escrow_names, results] = t.sent_actions()[0].data_as<std::tuple<name, vector<name>, vector<uint8_t>>>();
+    REQUIRE_EQUAL(approver, ARB1);
+    REQUIRE(escrow_names == (vector<name>{"escrow1"_n, "escrow2"_n, "escrow3"_n, "unknown"_n}));
+    REQUIRE(results == (vector<uint8_t>{0, 3, 2, 1}));
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->approvals, escrow_tester::approved_by_approver());
+}
+
+// lock
+
+ESCROW_TEST(lock) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    init(t, SENDER2, "escrow2"_n);
+
+    REQUIRE_ERROR("missing authority of arb1", t.push(SENDER1, &escrow::lock, "escrow1"_n, true));
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::lock, "escrow4"_n, true));
+    REQUIRE_ERROR("This has not been initialized with a transfer", t.push(ARB1, &escrow::lock, "escrow2"_n, true));
+
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    t.push(ARB1, &escrow::lock, "escrow1"_n, true);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->locked, true);
+
+    REQUIRE_ERROR("This escrow has been locked by the approver", t.push(SENDER1, &escrow::refund, "escrow1"_n));
+    REQUIRE_ERROR("This escrow has been locked by the approver", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+
+    t.push(ARB1, &escrow::lock, "escrow1"_n, false);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->locked, false);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+}
+
+// unapprove
+
+ESCROW_TEST(unapprove) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+
+    REQUIRE_ERROR("missing authority of arb1", t.push(SENDER2, &escrow::unapprove, "escrow1"_n, ARB1));
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::unapprove, "escrow4"_n, ARB1));
+    REQUIRE_ERROR("You have NOT approved this escrow", t.push(SENDER1, &escrow::unapprove, "escrow1"_n, SENDER1));
+    REQUIRE_ERROR("You have NOT approved this escrow", t.push(ARB2, &escrow::unapprove, "escrow1"_n, ARB2));
+
+    t.push(SENDER1, &escrow::approve, "escrow1"_n, SENDER1);
+    t.push(ARB1, &escrow::unapprove, "escrow1"_n, ARB1);
+    REQUIRE_ERROR("You have NOT approved this escrow", t.push(ARB1, &escrow::unapprove, "escrow1"_n, ARB1));
+
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->approvals, escrow_tester::approved_by_sender());
+}
+
+// claim
+
+ESCROW_TEST(claim) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    init(t, SENDER2, "escrow2"_n);
+
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::claim, "escrow4"_n));
+    REQUIRE_ERROR("This has not been initialized with a transfer", t.push(RECEIVER1, &escrow::claim, "escrow2"_n));
+    REQUIRE_ERROR("This escrow has not received the required approvals to claim", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+
+    // Anyone can claim an approved escrow, funds go to the receiver
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    t.push(SENDER2, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 50000);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 0);
+    REQUIRE(!t.get_escrow("escrow1"_n).has_value());
+    REQUIRE(!t.get_memo("escrow1"_n).has_value());
+
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+}
+
+ESCROW_TEST(claimall_pays_each_token_once) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 10000);
+    init_funded(t, SENDER2, "escrow2"_n, 20000);
+    init_funded(t, SENDER3, "escrow3"_n, 30000);
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    t.push(ARB1, &escrow::approve, "escrow3"_n, ARB1);
+
+    // The unapproved `escrow2` counts toward `max`, `escrow3` is left for the next claimall
+    t.push(RECEIVER1, &escrow::claimall, RECEIVER1, uint32_t(2));
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 10000);
+    REQUIRE(t.get_escrow("escrow3"_n).has_value());
+
+    t.push(RECEIVER1, &escrow::claimall, RECEIVER1, uint32_t(10));
+
+    REQUIRE_EQUAL(t.sent_actions().size(), 1u);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 40000);
+    REQUIRE(!t.get_escrow("escrow3"_n).has_value());
+    REQUIRE(t.get_escrow("escrow2"_n).has_value());
+    REQUIRE_ERROR("No claimable escrows for this receiver", t.push(RECEIVER1, &escrow::claimall, RECEIVER1, uint32_t(10)));
+}
+
+// cancel
+
+ESCROW_TEST(cancel) {
+    setup(t);
+    init(t, SENDER2, "escrow2"_n);
+
+    REQUIRE_ERROR("missing authority of sender2", t.push(SENDER1, &escrow::cancel, "escrow2"_n));
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(SENDER1, &escrow::cancel, "escrow4"_n));
+
+    t.transfer(SENDER2, escrow_tester::SELF, bos(60000), "here is a second memo");
+    REQUIRE_ERROR("Amount is not zero, this escrow is locked down", t.push(SENDER2, &escrow::cancel, "escrow2"_n));
+
+    init(t, SENDER1, "escrow3"_n, ARB2, EXPIRES, "third memo");
+    t.push(SENDER1, &escrow::cancel, "escrow3"_n);
+    REQUIRE(!t.get_escrow("escrow3"_n).has_value());
+    REQUIRE(!t.get_directory("escrow3"_n).has_value());
+    REQUIRE(!t.get_memo("escrow3"_n).has_value());
+    REQUIRE(t.get_escrow("escrow2"_n).has_value());
+}
+
+// refund
+
+ESCROW_TEST(refund) {
+    setup(t);
+    init_funded(t, SENDER2, "escrow2"_n, 60000);
+
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::refund, "escrow4"_n));
+    REQUIRE_ERROR("missing authority of sender2", t.push(ARB1, &escrow::refund, "escrow2"_n));
+
+    init(t, SENDER1, "escrow3"_n, ARB2, EXPIRES, "some empty memo");
+    REQUIRE_ERROR("This has not been initialized with a transfer", t.push(SENDER1, &escrow::refund, "escrow3"_n));
+
+    init_funded(t, SENDER4, "escrow4"_n, 50000, ARB2);
+    t.push(SENDER4, &escrow::approve, "escrow4"_n, SENDER4);
+    REQUIRE_ERROR("Escrow has not expired", t.push(SENDER4, &escrow::refund, "escrow4"_n));
+
+    // Refunds don't require approvals
+    init_funded(t, SENDER3, "escrow5"_n, 50000, ARB2);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 160000);
+    REQUIRE_EQUAL(t.balance(SENDER3), 9950000);
+
+    t.set_time(EXPIRES);
+    t.push(SENDER3, &escrow::refund, "escrow5"_n);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 110000);
+    REQUIRE_EQUAL(t.balance(SENDER3), 10000000);
+    REQUIRE(!t.get_escrow("escrow5"_n).has_value());
+}
+
+// extend
+
+ESCROW_TEST(extend) {
+    setup(t);
+    init_funded(t, SENDER2, "escrow2"_n, 60000);
+    init_funded(t, SENDER4, "escrow4"_n, 50000, ARB2);
+
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::extend, "unknown"_n, from_now(90000)));
+    REQUIRE_ERROR("missing authority of arb1", t.push(SENDER1, &escrow::extend, "escrow2"_n, from_now(90000000)));
+    REQUIRE_ERROR("You may only extend the expiry", t.push(SENDER2, &escrow::extend, "escrow2"_n, from_now(1000)));
+
+    t.push(SENDER2, &escrow::extend, "escrow2"_n, from_now(90000000));
+    REQUIRE_EQUAL(t.get_directory("escrow2"_n)->expires_at, from_now(90000000));
+
+    // The approver may shorten or extend the expiry
+    t.push(ARB2, &escrow::extend, "escrow4"_n, from_now(1000));
+    REQUIRE_EQUAL(t.get_directory("escrow4"_n)->expires_at, from_now(1000));
+    t.push(ARB2, &escrow::extend, "escrow4"_n, from_now(2000));
+    REQUIRE_EQUAL(t.get_directory("escrow4"_n)->expires_at, from_now(2000));
+}
+
+// close
+
+ESCROW_TEST(close) {
+    setup(t);
+    init_funded(t, SENDER2, "escrow2"_n, 60000);
+    init(t, SENDER1, "escrow3"_n, ARB2);
+    REQUIRE_EQUAL(t.balance(SENDER2), 9940000);
+
+    REQUIRE_ERROR("Could not find escrow with that name", t.push(ARB1, &escrow::close, "unknown"_n));
+    REQUIRE_ERROR("missing authority of arb1", t.push(SENDER1, &escrow::close, "escrow2"_n));
+    REQUIRE_ERROR("This has not been initialized with a transfer", t.push(ARB2, &escrow::close, "escrow3"_n));
+
+    t.push(ARB1, &escrow::close, "escrow2"_n);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 0);
+    REQUIRE_EQUAL(t.balance(SENDER2), 10000000);
+    REQUIRE(!t.get_escrow("escrow2"_n).has_value());
+}
+
+// expiry, the virtual clock is moved instead of waiting for escrows to lapse
+
+ESCROW_TEST(refund_opens_at_expiry) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+
+    t.set_time(time_point_sec(EXPIRES.sec_since_epoch() - 1));
+    REQUIRE_ERROR("Escrow has not expired", t.push(SENDER1, &escrow::refund, "escrow1"_n));
+
+    t.advance(1);
+    t.push(SENDER1, &escrow::refund, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(SENDER1), 10000000);
+}
+
+ESCROW_TEST(maximum_expiry_follows_the_clock) {
+    setup(t);
+    t.advance(escrow_tester::SIX_MONTHS_IN_SECONDS);
+
+    REQUIRE_ERROR("expires_at must be a value in the future.", init(t, SENDER1, "escrow1"_n, ARB1, t.now()));
+    REQUIRE_ERROR("expires_at must be within the maximum expiry from now.",
+        init(t, SENDER1, "escrow1"_n, ARB1, t.now() + escrow_tester::SIX_MONTHS_IN_SECONDS + 1));
+
+    init(t, SENDER1, "escrow1"_n, ARB1, t.now() + escrow_tester::SIX_MONTHS_IN_SECONDS);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->created_at, from_now(escrow_tester::SIX_MONTHS_IN_SECONDS));
+
+    // A shorter maximum applies from the next escrow
+    t.push(escrow_tester::SELF, &escrow::setconfig,
+        vector<name>{SENDER1}, vector<name>{ARB1}, escrow_tester::TOKEN, BOS, 7 * DAY);
+    REQUIRE_ERROR("expires_at must be within the maximum expiry from now.", init(t, SENDER1, "escrow2"_n, ARB1, t.now() + 7 * DAY + 1));
+    init(t, SENDER1, "escrow2"_n, ARB1, t.now() + 7 * DAY);
+}
+
+ESCROW_TEST(extend_postpones_the_refund) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    t.push(SENDER1, &escrow::extend, "escrow1"_n, time_point_sec(EXPIRES + DAY));
+
+    t.set_time(EXPIRES);
+    REQUIRE_ERROR("Escrow has not expired", t.push(SENDER1, &escrow::refund, "escrow1"_n));
+    REQUIRE_ERROR("No expired escrows to refund", t.push(SENDER2, &escrow::sweep, uint32_t(10)));
+
+    t.advance(DAY);
+    t.push(SENDER1, &escrow::refund, "escrow1"_n);
+}
+
+ESCROW_TEST(sweep_refunds_expired_escrows_oldest_first) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n, ARB1, from_now(DAY));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(10000), "escrow1");
+    init(t, SENDER1, "escrow2"_n, ARB1, from_now(2 * DAY));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(20000), "escrow2");
+    init(t, SENDER1, "escrow3"_n, ARB1, from_now(3 * DAY));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(30000), "escrow3");
+    init(t, SENDER2, "escrow4"_n, ARB1, from_now(DAY));
+    t.transfer(SENDER2, escrow_tester::SELF, bos(40000), "escrow4");
+    init(t, SENDER3, "escrow5"_n, ARB1, from_now(DAY));
+    t.push(ARB1, &escrow::lock, "escrow4"_n, true);
+
+    REQUIRE_ERROR("No expired escrows to refund", t.push(SENDER4, &escrow::sweep, uint32_t(10)));
+
+    // Locked & empty escrows are skipped, refunds of the same sender are paid with one transfer
+    t.advance(2 * DAY);
+    t.push(SENDER4, &escrow::sweep, uint32_t(10));
+    REQUIRE_EQUAL(t.sent_actions().size(), 1u);
+    const auto [from, to, quantity, memo] = t.sent_actions()[0].data_as<std::tuple<name, name, asset, string>>();
+    REQUIRE_EQUAL(to, SENDER1);
+    REQUIRE_EQUAL(quantity, bos(30000));
+    REQUIRE_EQUAL(memo, string("escrows escrow1 escrow2"));
+    REQUIRE(t.get_escrow("escrow3"_n).has_value());
+    REQUIRE(t.get_escrow("escrow4"_n).has_value());
+    REQUIRE(t.get_escrow("escrow5"_n).has_value());
+
+    // The locked & empty escrows at the head of `byexpiry` use up `max_rows`
+    t.advance(DAY);
+    REQUIRE_ERROR("No expired escrows to refund", t.push(SENDER4, &escrow::sweep, uint32_t(2)));
+    t.push(SENDER4, &escrow::sweep, uint32_t(3));
+    REQUIRE(!t.get_escrow("escrow3"_n).has_value());
+    REQUIRE_EQUAL(t.balance(SENDER1), 10000000);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 40000);
+}
+
+ESCROW_TEST(tranches_unlock_with_the_clock) {
+    setup(t);
+    const vector<escrow::tranche_spec> tranches = {{20000, from_now(DAY)}, {30000, from_now(2 * DAY)}};
+    REQUIRE_ERROR("tranche must unlock before expires_at",
+        t.push(SENDER1, &escrow::initsched, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(DAY), string("milestones"), tranches));
+    REQUIRE_ERROR("tranche must unlock before expires_at",
+        t.push(SENDER1, &escrow::initsched, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(2 * DAY), string("milestones"), tranches));
+
+    t.push(SENDER1, &escrow::initsched, SENDER1, RECEIVER1, ARB1, "escrow1"_n, EXPIRES, string("milestones"), tranches);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow1");
+    t.push(ARB1, &escrow::approvetr, "escrow1"_n, ARB1, uint8_t(0));
+    t.push(ARB1, &escrow::approvetr, "escrow1"_n, ARB1, uint8_t(1));
+
+    REQUIRE_ERROR("This tranche has not unlocked yet", t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(0)));
+    t.advance(DAY);
+    t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(0));
+    REQUIRE_ERROR("This tranche has not unlocked yet", t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(1)));
+    t.advance(DAY);
+    t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(1));
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 50000);
+}
+
+ESCROW_TEST(vesting_pays_out_linearly) {
+    setup(t);
+    REQUIRE_ERROR("start_at must be before end_at",
+        t.push(SENDER1, &escrow::initvest, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(DAY), from_now(DAY), EXPIRES, string("vesting")));
+    REQUIRE_ERROR("end_at must be before expires_at",
+        t.push(SENDER1, &escrow::initvest, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(DAY), time_point_sec(EXPIRES + 1), EXPIRES, string("vesting")));
+
+    t.push(SENDER1, &escrow::initvest, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(DAY), from_now(5 * DAY), EXPIRES, string("vesting"));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(100000), "escrow1");
+    REQUIRE_ERROR("This escrow has not received the required approvals to claim", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+
+    REQUIRE_ERROR("Nothing has vested since the last claim", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+
+    // A quarter of the vesting period
+    t.advance(2 * DAY);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 25000);
+    REQUIRE_EQUAL(t.get_vesting("escrow1"_n)->claimed, 25000);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(75000));
+    REQUIRE_ERROR("Nothing has vested since the last claim", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+
+    // Rounds down, the rest is paid out once fully vested
+    t.advance(DAY / 3);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 33333);
+
+    t.advance(10 * DAY);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 100000);
+    REQUIRE(!t.get_escrow("escrow1"_n).has_value());
+    REQUIRE(!t.get_vesting("escrow1"_n).has_value());
+}
+
+ESCROW_TEST(unvested_balance_is_refunded_after_expiry) {
+    setup(t);
+    t.push(SENDER1, &escrow::initvest, SENDER1, RECEIVER1, ARB1, "escrow1"_n, from_now(0), from_now(10 * DAY), from_now(10 * DAY), string("vesting"));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(100000), "escrow1");
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+
+    t.advance(4 * DAY);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    t.push(ARB1, &escrow::lock, "escrow1"_n, true);
+
+    t.advance(6 * DAY);
+    REQUIRE_ERROR("This escrow has been locked by the approver", t.push(SENDER1, &escrow::refund, "escrow1"_n));
+    t.push(ARB1, &escrow::close, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 40000);
+    REQUIRE_EQUAL(t.balance(SENDER1), 9960000);
+    REQUIRE(!t.get_vesting("escrow1"_n).has_value());
+}
+
+// fees
+
+ESCROW_TEST(approver_fee_is_exact_up_to_max_amount) {
+    // BOS max supply is 10,000,000,000.0000 BOS, then up to the largest asset amount
+    const vector<int64_t> amounts = {
+        1, 9, 10001, 123456789, 99999999999999, 100000000000000, 100000000000001, asset::max_amount
+    };
+
+    for (const int64_t amount : amounts) {
+        for (const uint16_t fee_bps : {uint16_t(0), uint16_t(1), uint16_t(1000), uint16_t(9999)}) {
+            escrow_tester fresh;
+            setup(fresh);
+            fresh.push(escrow_tester::SELF, &escrow::setfee, ARB1, fee_bps);
+            fresh.issue(SENDER1, bos(amount));
+            init_funded(fresh, SENDER1, "escrow1"_n, amount);
+            fresh.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+
+            // amount * (10000 - bps) / 10000 without an intermediate above 2^63, dust amounts keep 1 unit
+            const int64_t kept = std::max<int64_t>(1, (amount / 10000) * (10000 - fee_bps) + (amount % 10000) * (10000 - fee_bps) / 10000);
+            REQUIRE_EQUAL(fresh.get_escrow("escrow1"_n)->ext_asset.quantity.amount, kept);
+            REQUIRE_EQUAL(fresh.get_fee_pool().undistributed, amount - kept);
+        }
+    }
+
+    // A fee of 100% would leave an approved escrow with nothing to claim
+    escrow_tester dust;
+    setup(dust);
+    REQUIRE_ERROR("fee_bps must be less than 10000", dust.push(escrow_tester::SELF, &escrow::setfee, ARB1, uint16_t(10000)));
+
+    // An approved escrow stays funded, a later transfer without memo cannot be deposited to it
+    dust.push(escrow_tester::SELF, &escrow::setfee, ARB1, uint16_t(9999));
+    init_funded(dust, SENDER1, "escrow1"_n, 1);
+    dust.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+    REQUIRE_EQUAL(dust.get_escrow("escrow1"_n)->ext_asset.quantity, bos(1));
+    REQUIRE_ERROR("Could not find existing escrow to deposit to", dust.transfer(SENDER1, escrow_tester::SELF, bos(50000), ""));
+
+    // The former `amount * 0.90` rounds through a double at large amounts
+    const int64_t exact = (asset::max_amount / 10000) * 9000 + (asset::max_amount % 10000) * 9000 / 10000;
+    REQUIRE(static_cast<int64_t>(asset::max_amount * 0.90) != exact);
+}
+
+ESCROW_TEST(eosio_withholds_ten_percent_by_default) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow1"_n, "eosio"_n);
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 45000);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 5000);
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 5000);
+}
+
+ESCROW_TEST(fee_pool_is_shared_by_weight) {
+    setup(t);
+    t.create_accounts({"bp1"_n, "bp2"_n});
+
+    t.push(escrow_tester::SELF, &escrow::setshares, "bp1"_n, uint64_t(1));
+    t.push(escrow_tester::SELF, &escrow::setshares, "bp2"_n, uint64_t(3));
+    REQUIRE_EQUAL(t.get_fee_pool().total_shares, 4u);
+
+    init_funded(t, SENDER1, "escrow1"_n, 100000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow1"_n, "eosio"_n);
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 0);
+
+    init_funded(t, SENDER2, "escrow2"_n, 100000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow2"_n, "eosio"_n);
+
+    REQUIRE_ERROR("missing authority of bp1", t.push("bp2"_n, &escrow::claimfees, "bp1"_n));
+    t.push("bp1"_n, &escrow::claimfees, "bp1"_n);
+    t.push("bp2"_n, &escrow::claimfees, "bp2"_n);
+    REQUIRE_EQUAL(t.balance("bp1"_n), 5000);
+    REQUIRE_EQUAL(t.balance("bp2"_n), 15000);
+    REQUIRE_ERROR("No fees to claim", t.push("bp1"_n, &escrow::claimfees, "bp1"_n));
+
+    // Removing the shares keeps the fees accrued so far
+    init_funded(t, SENDER3, "escrow3"_n, 100000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow3"_n, "eosio"_n);
+    t.push(escrow_tester::SELF, &escrow::setshares, "bp2"_n, uint64_t(0));
+    REQUIRE_EQUAL(t.get_fee_share("bp2"_n)->pending, 7500);
+    t.push("bp2"_n, &escrow::claimfees, "bp2"_n);
+    REQUIRE(!t.get_fee_share("bp2"_n).has_value());
+    REQUIRE_EQUAL(t.balance("bp2"_n), 22500);
+
+    // Only the unclaimed escrow amounts & the unclaimed fees are left with escrow.bos
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 3 * 90000 + 2500);
+}
+
+ESCROW_TEST(escrows_of_other_tokens_are_approved_without_fee) {
+    setup(t);
+    t.create_accounts({"other.token"_n});
+    t.issue(SENDER1, bos(50000), "other.token"_n);
+    t.push(escrow_tester::SELF, &escrow::addtoken, "other.token"_n, BOS);
+
+    // `eosio` withholds 10% of the pool token, nothing of a token outside the pool
+    init(t, SENDER1, "escrow1"_n, "eosio"_n);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow1", "other.token"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow1"_n, "eosio"_n);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(50000));
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 0);
+
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1, BOS, "other.token"_n), 50000);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF, BOS, "other.token"_n), 0);
+
+    // Tranches too
+    t.issue(SENDER1, bos(50000), "other.token"_n);
+    const vector<escrow::tranche_spec> tranches = {{20000, from_now(0)}, {30000, from_now(0)}};
+    t.push(SENDER1, &escrow::initsched, SENDER1, RECEIVER1, "eosio"_n, "escrow2"_n, EXPIRES, string("milestones"), tranches);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow2", "other.token"_n);
+    t.push("eosio"_n, &escrow::approvetr, "escrow2"_n, "eosio"_n, uint8_t(0));
+    REQUIRE_EQUAL(t.get_schedule("escrow2"_n)->tranches[0].amount, 20000);
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 0);
+
+    // The pool token still pays the fee
+    init_funded(t, SENDER2, "escrow3"_n, 50000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow3"_n, "eosio"_n);
+    REQUIRE_EQUAL(t.get_escrow("escrow3"_n)->ext_asset.quantity, bos(45000));
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 5000);
+}
+
+ESCROW_TEST(fees_withheld_before_any_shares_go_to_the_first_beneficiaries) {
+    setup(t);
+    t.create_accounts({"bp1"_n, "bp2"_n});
+
+    init_funded(t, SENDER1, "escrow1"_n, 100000, "eosio"_n);
+    t.push("eosio"_n, &escrow::approve, "escrow1"_n, "eosio"_n);
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 10000);
+
+    // The first shareholder gets all of it, later shareholders none of it
+    t.push(escrow_tester::SELF, &escrow::setshares, "bp1"_n, uint64_t(1));
+    t.push(escrow_tester::SELF, &escrow::setshares, "bp2"_n, uint64_t(3));
+    REQUIRE_EQUAL(t.get_fee_pool().undistributed, 0);
+
+    t.push("bp1"_n, &escrow::claimfees, "bp1"_n);
+    REQUIRE_EQUAL(t.balance("bp1"_n), 10000);
+    REQUIRE_ERROR("No fees to claim", t.push("bp2"_n, &escrow::claimfees, "bp2"_n));
+}
+
+// stats
+
+ESCROW_TEST(stats_follow_every_escrow_change) {
+    setup(t);
+    init(t, SENDER1, "escrow1"_n);
+    init_funded(t, SENDER2, "escrow2"_n, 50000);
+    init_funded(t, SENDER3, "escrow3"_n, 70000);
+    t.push(ARB1, &escrow::approve, "escrow2"_n, ARB1);
+    t.push(ARB1, &escrow::lock, "escrow3"_n, true);
+
+    auto stats = t.get_stats();
+    REQUIRE_EQUAL(stats.open, 3u);
+    REQUIRE_EQUAL(stats.funded, 2u);
+    REQUIRE_EQUAL(stats.approved, 1u);
+    REQUIRE_EQUAL(stats.locked, 1u);
+    REQUIRE_EQUAL(stats.held.size(), 1u);
+    REQUIRE_EQUAL(stats.held[0].quantity, bos(120000));
+
+    t.push(RECEIVER1, &escrow::claim, "escrow2"_n);
+    t.push(ARB1, &escrow::close, "escrow3"_n);
+    t.push(SENDER1, &escrow::cancel, "escrow1"_n);
+
+    stats = t.get_stats();
+    REQUIRE_EQUAL(stats.open, 0u);
+    REQUIRE_EQUAL(stats.funded, 0u);
+    REQUIRE_EQUAL(stats.approved, 0u);
+    REQUIRE_EQUAL(stats.locked, 0u);
+    REQUIRE(stats.held.empty());
+}
+
+// milestones
+
+ESCROW_TEST(milestone_tranches_are_approved_and_claimed_one_by_one) {
+    setup(t);
+    const vector<escrow::tranche_spec> tranches = {{20000, from_now(0)}, {30000, from_now(0)}};
+    t.push(SENDER1, &escrow::initsched, SENDER1, RECEIVER1, ARB1, "escrow1"_n, EXPIRES, string("milestones"), tranches);
+
+    REQUIRE_ERROR("Deposit must equal the sum of the tranches", t.transfer(SENDER1, escrow_tester::SELF, bos(40000), "escrow1"));
+    t.transfer(SENDER1, escrow_tester::SELF, bos(50000), "escrow1");
+
+    REQUIRE_ERROR("Approve the tranches of this escrow with approvetr", t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1));
+    REQUIRE_ERROR("Claim the tranches of this escrow with claimtr", t.push(RECEIVER1, &escrow::claim, "escrow1"_n));
+
+    REQUIRE_ERROR("Unapprove the tranches of this escrow with unapprovetr", t.push(ARB1, &escrow::unapprove, "escrow1"_n, ARB1));
+
+    // A tranche approval is withdrawn with unapprovetr until the tranche is claimed
+    // The escrow counts as approved while one of its unclaimed tranches is approved
+    t.push(ARB1, &escrow::approvetr, "escrow1"_n, ARB1, uint8_t(0));
+    REQUIRE_EQUAL(t.get_stats().approved, 1u);
+    REQUIRE_ERROR("You have NOT approved this tranche", t.push(SENDER1, &escrow::unapprovetr, "escrow1"_n, SENDER1, uint8_t(0)));
+    t.push(ARB1, &escrow::unapprovetr, "escrow1"_n, ARB1, uint8_t(0));
+    REQUIRE_EQUAL(t.get_schedule("escrow1"_n)->tranches[0].approvals, 0);
+    REQUIRE_EQUAL(t.get_stats().approved, 0u);
+
+    t.push(ARB1, &escrow::approvetr, "escrow1"_n, ARB1, uint8_t(1));
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->approvals, escrow_tester::approved_by_approver());
+    REQUIRE_ERROR("This tranche has not received the required approvals to claim", t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(0)));
+    REQUIRE_ERROR("Could not find tranche with that index", t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(2)));
+
+    t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(1));
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 30000);
+    REQUIRE_EQUAL(t.get_escrow("escrow1"_n)->ext_asset.quantity, bos(20000));
+    REQUIRE_EQUAL(t.get_stats().approved, 0u);
+    REQUIRE_ERROR("This tranche has already been claimed", t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(1)));
+    REQUIRE_ERROR("This tranche has already been claimed", t.push(ARB1, &escrow::unapprovetr, "escrow1"_n, ARB1, uint8_t(1)));
+
+    // Last tranche removes the escrow & its schedule
+    t.push(SENDER1, &escrow::approvetr, "escrow1"_n, SENDER1, uint8_t(0));
+    REQUIRE_EQUAL(t.get_stats().approved, 1u);
+    t.push(RECEIVER1, &escrow::claimtr, "escrow1"_n, uint8_t(0));
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 50000);
+    REQUIRE_EQUAL(t.get_stats().approved, 0u);
+    REQUIRE(!t.get_escrow("escrow1"_n).has_value());
+    REQUIRE(!t.get_schedule("escrow1"_n).has_value());
+}
+
+// maintenance
+
+ESCROW_TEST(clean_resumes_from_its_cursor) {
+    setup(t);
+    for (const name escrow_name : {"escrow1"_n, "escrow2"_n, "escrow3"_n}) {
+        init(t, SENDER1, escrow_name);
+    }
+
+    REQUIRE_ERROR("missing authority of escrow.bos", t.push(SENDER1, &escrow::clean, uint32_t(2)));
+    t.push(escrow_tester::SELF, &escrow::clean, uint32_t(2));
+    REQUIRE_EQUAL(t.console(), string("clean removed 2 rows (2 in total), 1 rows remaining"));
+    REQUIRE(t.get_escrow("escrow3"_n).has_value());
+
+    t.push(escrow_tester::SELF, &escrow::clean, uint32_t(2));
+    REQUIRE_EQUAL(t.console(), string("clean removed 1 rows (3 in total), 0 rows remaining"));
+    REQUIRE_EQUAL(t.get_stats().open, 0u);
+    REQUIRE(!t.get_memo("escrow3"_n).has_value());
+}
+
+ESCROW_TEST(migrate_moves_legacy_rows_to_the_scope_of_their_sender) {
+    setup(t);
+    const extended_asset empty{bos(0), escrow_tester::TOKEN};
+    const extended_asset funded{bos(50000), escrow_tester::TOKEN};
+    t.store_legacy_escrow({"escrow1"_n, SENDER1, RECEIVER1, ARB1, {ARB1}, funded, "memo1", from_now(0), EXPIRES});
+    t.store_legacy_escrow({"escrow2"_n, SENDER1, RECEIVER1, ARB1, {}, empty, "memo2", from_now(0), EXPIRES});
+    t.store_legacy_escrow({"escrow3"_n, SENDER2, RECEIVER1, ARB2, {}, funded, "memo3", from_now(0), EXPIRES, true});
+    t.issue(escrow_tester::SELF, bos(100000));
+
+    // Names of rows not moved yet stay taken
+    REQUIRE_ERROR("escrow with same name already exists", init(t, SENDER3, "escrow3"_n));
+
+    REQUIRE_ERROR("missing authority of escrow.bos", t.push(SENDER1, &escrow::migrate, uint32_t(2)));
+    t.push(escrow_tester::SELF, &escrow::migrate, uint32_t(2));
+    REQUIRE_EQUAL(t.console(), string("migrate moved 2 rows, more rows remaining"));
+    t.push(escrow_tester::SELF, &escrow::migrate, uint32_t(2));
+    REQUIRE_EQUAL(t.console(), string("migrate moved 1 rows, no rows remaining"));
+
+    const auto row = t.get_escrow("escrow1"_n);
+    REQUIRE(row.has_value());
+    REQUIRE_EQUAL(row->approvals, escrow_tester::approved_by_approver());
+    REQUIRE_EQUAL(row->ext_asset, funded);
+    REQUIRE_EQUAL(t.get_directory("escrow1"_n)->receiver, RECEIVER1);
+    REQUIRE_EQUAL(t.get_directory("escrow1"_n)->expires_at, EXPIRES);
+    REQUIRE_EQUAL(*t.get_memo("escrow2"_n), string("memo2"));
+    REQUIRE(t.get_escrow("escrow3"_n)->locked);
+
+    const auto stats = t.get_stats();
+    REQUIRE_EQUAL(stats.open, 3u);
+    REQUIRE_EQUAL(stats.funded, 2u);
+    REQUIRE_EQUAL(stats.approved, 1u);
+    REQUIRE_EQUAL(stats.locked, 1u);
+
+    // Migrated escrows keep working, the deposit of `escrow1` goes to its receiver & `escrow2` is filled by memo
+    t.push(RECEIVER1, &escrow::claim, "escrow1"_n);
+    REQUIRE_EQUAL(t.balance(RECEIVER1), 50000);
+    t.transfer(SENDER1, escrow_tester::SELF, bos(10000), "escrow2");
+    REQUIRE_EQUAL(t.get_escrow("escrow2"_n)->ext_asset.quantity, bos(10000));
+}
+
+ESCROW_TEST(failed_action_reverts_its_changes) {
+    setup(t);
+    init_funded(t, SENDER1, "escrow1"_n, 50000);
+    init_funded(t, SENDER2, "escrow2"_n, 50000);
+    t.push(ARB1, &escrow::approve, "escrow1"_n, ARB1);
+
+    // The second name is unknown, the whole batch of `initmany` is reverted
+    const vector<escrow::escrow_spec> specs = {
+        {RECEIVER1, ARB1, "escrow3"_n, EXPIRES, "memo"},
+        {"nobody"_n, ARB1, "escrow4"_n, EXPIRES, "memo"}
+    };
+    REQUIRE_ERROR("receiver account does not exist", t.push(SENDER3, &escrow::initmany, SENDER3, specs));
+    REQUIRE(!t.get_escrow("escrow3"_n).has_value());
+    REQUIRE(!t.get_memo("escrow3"_n).has_value());
+    REQUIRE_EQUAL(t.get_stats().open, 2u);
+    REQUIRE_EQUAL(t.balance(escrow_tester::SELF), 100000);
+}
+
+int main() {
+    return run_tests();
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "escrow.hpp"
+
+#include <eosio/host.hpp>
+
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+// In-process test harness, runs the escrow actions on the host chain of host/eosio
+// Token balances are kept by the harness, `eosio.token::transfer` is applied for the transfers sent by escrow.bos
+// Tables are read through the public table types of escrow.hpp, as any other reader of the contract state
+
+class escrow_tester {
+    public:
+        static constexpr name SELF = "escrow.bos"_n;
+        static constexpr name TOKEN = "eosio.token"_n;
+        static constexpr uint32_t SIX_MONTHS_IN_SECONDS = escrow::SIX_MONTHS_IN_SECONDS;
+        static constexpr uint64_t FEE_PRECISION = escrow::FEE_PRECISION;
+
+        // 2020-01-01T00:00:00
+        static constexpr uint32_t START = 1577836800;
+
+        escrow_tester() {
+            auto& state = eosio::host::chain();
+            state.reset();
+            state.now = time_point_sec(START);
+            create_accounts({SELF, TOKEN, "eosio"_n});
+        }
+
+        void create_accounts( std::initializer_list<name> accounts ) {
+            for (const name account : accounts) {
+                eosio::host::chain().accounts.insert(account);
+            }
+        }
+
+        void issue( const name to, const asset& quantity, const name token = TOKEN ) {
+            ledger[{to, eosio::extended_symbol{quantity.symbol, token}}] += quantity.amount;
+        }
+
+        int64_t balance( const name account, const symbol sym = symbol{"BOS", 4}, const name token = TOKEN ) const {
+            auto itr = ledger.find({account, eosio::extended_symbol{sym, token}});
+            return itr == ledger.end() ? 0 : itr->second;
+        }
+
+        // Pushes an escrow action authorized by `actor`, a failed `check` reverts the action & is rethrown
+        template<typename... Params, typename... Args>
+        void push( const name actor, void (escrow::*act)(Params...), Args&&... args ) {
+            run({actor}, SELF, act, std::forward<Args>(args)...);
+        }
+
+        // `token::transfer` from `from` to `to`, escrow.bos is notified when it receives the tokens
+        void transfer( const name from, const name to, const asset& quantity, const string& memo, const name token = TOKEN ) {
+            transfer_as(from, from, to, quantity, memo, token);
+        }
+
+        void transfer_as( const name actor, const name from, const name to, const asset& quantity, const string& memo, const name token = TOKEN ) {
+            auto saved = ledger;
+            try {
+                eosio::check(actor == from, "missing authority of " + from.to_string());
+                move_tokens(token, from, to, quantity, memo);
+                if (to == SELF) {
+                    run({actor}, token, &escrow::transfer, from, to, quantity, memo);
+                }
+            } catch (...) {
+                ledger = saved;
+                throw;
+            }
+        }
+
+        // Writes `row` as the contract did before escrows were scoped by sender, see `migrate`
+        void store_legacy_escrow( const escrow::legacy_escrow_row& row ) {
+            escrow::legacy_escrows_table legacy(SELF, SELF.value);
+            legacy.emplace(row.sender, [&](auto & r) {
+                r = row;
+            });
+        }
+
+        // Virtual clock of the chain, expiry tests jump over it instead of waiting
+        time_point_sec now() const { return time_point_sec(eosio::host::chain().now); }
+        void set_time( const time_point_sec time ) { eosio::host::chain().now = time; }
+        void advance( const uint32_t seconds ) { set_time(now() + seconds); }
+
+        // Inline actions sent by the last action
+        const vector<eosio::action>& sent_actions() const { return eosio::host::chain().actions; }
+
+        const string& console() const { return eosio::host::chain().console; }
+
+        std::optional<escrow::escrow_row> get_escrow( const name escrow_name ) const {
+            escrow::directory_table directory(SELF, SELF.value);
+            auto dir_itr = directory.find(escrow_name.value);
+            if (dir_itr == directory.end()) {
+                return {};
+            }
+            escrow::escrows_table escrows(SELF, dir_itr->sender.value);
+            return escrows.get(escrow_name.value, "escrow is missing from the scope of its sender");
+        }
+
+        std::optional<escrow::directory_row> get_directory( const name escrow_name ) const {
+            escrow::directory_table directory(SELF, SELF.value);
+            auto dir_itr = directory.find(escrow_name.value);
+            return dir_itr == directory.end() ? std::optional<escrow::directory_row>{} : *dir_itr;
+        }
+
+        std::optional<string> get_memo( const name escrow_name ) const {
+            escrow::memos_table memos(SELF, SELF.value);
+            auto memo_itr = memos.find(escrow_name.value);
+            return memo_itr == memos.end() ? std::optional<string>{} : memo_itr->memo;
+        }
+
+        std::optional<escrow::schedule_row> get_schedule( const name escrow_name ) const {
+            escrow::schedules_table schedules(SELF, SELF.value);
+            auto itr = schedules.find(escrow_name.value);
+            return itr == schedules.end() ? std::optional<escrow::schedule_row>{} : *itr;
+        }
+
+        std::optional<escrow::vesting_row> get_vesting( const name escrow_name ) const {
+            escrow::vestings_table vestings(SELF, SELF.value);
+            auto itr = vestings.find(escrow_name.value);
+            return itr == vestings.end() ? std::optional<escrow::vesting_row>{} : *itr;
+        }
+
+        std::optional<escrow::fee_share_row> get_fee_share( const name account ) const {
+            escrow::fee_shares_table fee_shares(SELF, SELF.value);
+            auto itr = fee_shares.find(account.value);
+            return itr == fee_shares.end() ? std::optional<escrow::fee_share_row>{} : *itr;
+        }
+
+        escrow::stats_row get_stats() const {
+            return escrow::stats_singleton(SELF, SELF.value).get_or_default();
+        }
+
+        escrow::fee_pool_row get_fee_pool() const {
+            return escrow::fee_pool_singleton(SELF, SELF.value).get_or_default();
+        }
+
+        static uint8_t approved_by_sender() { return escrow::APPROVED_BY_SENDER; }
+        static uint8_t approved_by_approver() { return escrow::APPROVED_BY_APPROVER; }
+
+    private:
+        std::map<std::pair<name, eosio::extended_symbol>, int64_t> ledger;
+
+        template<typename... Params, typename... Args>
+        void run( vector<name> authorizers, const name code, void (escrow::*act)(Params...), Args&&... args ) {
+            auto saved = ledger;
+            try {
+                eosio::host::push_action(SELF, code, std::move(authorizers), act, std::forward<Args>(args)...);
+
+                // Transfers sent by escrow.bos belong to the same transaction, a failed transfer reverts the action
+                for (const auto& act : eosio::host::chain().actions) {
+                    if (act.name != "transfer"_n) {
+                        continue;
+                    }
+                    const auto [from, to, quantity, memo] = act.data_as<std::tuple<name, name, asset, string>>();
+                    eosio::check(act.authorization.at(0).actor == from, "missing authority of " + from.to_string());
+                    move_tokens(act.account, from, to, quantity, memo);
+                }
+            } catch (...) {
+                ledger = saved;
+                eosio::host::chain().rollback();
+                throw;
+            }
+        }
+
+        // Checks of `eosio.token::transfer`
+        void move_tokens( const name token, const name from, const name to, const asset& quantity, const string& memo ) {
+            eosio::check(from != to, "cannot transfer to self");
+            eosio::check(eosio::is_account(to), "to account does not exist");
+            eosio::check(quantity.is_valid(), "invalid quantity");
+            eosio::check(quantity.amount > 0, "must transfer positive quantity");
+            eosio::check(memo.size() <= 256, "memo has more than 256 bytes");
+
+            auto& from_balance = ledger[{from, eosio::extended_symbol{quantity.symbol, token}}];
+            eosio::check(from_balance >= quantity.amount, "overdrawn balance");
+            from_balance -= quantity.amount;
+            ledger[{to, eosio::extended_symbol{quantity.symbol, token}}] += quantity.amount;
+        }
+};
+
+// Minimal test runner, every test gets a fresh chain
+
+struct test_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct test_case {
+    const char* name;
+    void (*run)(escrow_tester&);
+};
+
+inline vector<test_case>& test_cases() {
+    static vector<test_case> cases;
+    return cases;
+}
+
+struct test_registrar {
+    test_registrar( const char* name, void (*run)(escrow_tester&) ) { test_cases().push_back({name, run}); }
+};
+
+#define ESCROW_TEST(test_name) \
+    static void test_name(escrow_tester& t); \
+    static test_registrar test_name##_registrar(#test_name, test_name); \
+    static void test_name(escrow_tester& t)
+
+#define TEST_FAIL(message) \
+    do { \
+        std::ostringstream os_; \
+        os_ << __FILE__ << ":" << __LINE__ << ": " << message; \
+        throw test_failure(os_.str()); \
+    } while (0)
+
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) TEST_FAIL("REQUIRE(" #condition ") failed"); \
+    } while (0)
+
+#define REQUIRE_EQUAL(actual, expected) \
+    do { \
+        const auto actual_ = (actual); \
+        const auto expected_ = (expected); \
+        if (!(actual_ == expected_)) TEST_FAIL("REQUIRE_EQUAL(" #actual ", " #expected ") failed: " << describe(actual_) << " != " << describe(expected_)); \
+    } while (0)
+
+// Runs `statement` & requires it to fail a `check` whose message contains `message`
+#define REQUIRE_ERROR(message, ...) \
+    do { \
+        try { \
+            __VA_ARGS__; \
+        } catch (const eosio::host::assertion_failure& e_) { \
+            if (string(e_.what()).find(message) != string::npos) break; \
+            TEST_FAIL("expected error \"" << message << "\", got \"" << e_.what() << "\""); \
+        } \
+        TEST_FAIL("expected error \"" << message << "\", " #__VA_ARGS__ " succeeded"); \
+    } while (0)
+
+inline string describe( const name& n ) { return n.to_string(); }
+inline string describe( const asset& a ) { return a.to_string(); }
+inline string describe( const string& s ) { return "\"" + s + "\""; }
+inline string describe( const time_point_sec& t ) { return std::to_string(t.sec_since_epoch()); }
+inline string describe( const eosio::extended_asset& a ) { return a.quantity.to_string() + "@" + a.contract.to_string(); }
+inline string describe( bool b ) { return b ? "true" : "false"; }
+
+template<typename T>
+auto describe( const T& value ) -> decltype(std::to_string(value)) { return std::to_string(value); }
+
+inline string describe( unsigned __int128 value ) {
+    string digits;
+    do {
+        digits.insert(digits.begin(), static_cast<char>('0' + static_cast<int>(value % 10)));
+        value /= 10;
+    } while (value > 0);
+    return digits;
+}
+
+inline int run_tests() {
+    int failed = 0;
+    for (const auto& test : test_cases()) {
+        escrow_tester t;
+        try {
+            test.run(t);
+        } catch (const test_failure& e) {
+            std::printf("FAIL %s\n  %s\n", test.name, e.what());
+            ++failed;
+        } catch (const std::exception& e) {
+            std::printf("FAIL %s\n  unexpected exception: %s\n", test.name, e.what());
+            ++failed;
+        }
+    }
+    std::printf("%zu tests, %d failed\n", test_cases().size(), failed);
+    return failed == 0 ? 0 : 1;
+}